@@ -0,0 +1,193 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+#include "raylib.h"
+
+// Buckets of the nodes-expanded histogram: 0-1, 2-3, 4-7, ... the last one takes everything above.
+constexpr int AI_STATS_HISTOGRAM_BUCKETS = 14;
+// Ticks the overlay panel averages over.
+constexpr int AI_STATS_WINDOW = 120;
+constexpr int AI_STATS_PANEL_W = 250;
+constexpr int AI_STATS_FONT_SIZE = 10;
+
+// Path finding and enemy AI work of a single simulation tick.
+struct AiTickSample {
+  int path_calls{};
+  int path_failures{};
+  u_int64_t nodes_expanded{};
+  int heap_peak{};
+  float path_ms{};
+  int enemy_no_path{};
+};
+
+// Totals since the last `AiStats::reset`, for the reports.
+struct AiSummary {
+  int ticks{};
+  u_int64_t path_calls{};
+  u_int64_t path_failures{};
+  u_int64_t nodes_expanded{};
+  int heap_high_water{};
+  double path_ms{};
+  int max_tick_calls{};
+  u_int64_t enemy_path_requests{};
+  u_int64_t enemy_no_path{};
+  std::array<u_int64_t, AI_STATS_HISTOGRAM_BUCKETS> nodes_histogram{};
+};
+
+inline int ai_stats_bucket(u_int64_t value) {
+  int bucket{0};
+  while (value > 1 && bucket < AI_STATS_HISTOGRAM_BUCKETS - 1) {
+    value >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+/**
+ * Counters of the path finder and the enemy AI. Queries run on the job system threads, so the counters are relaxed
+ * atomics, bumped once per query. `end_tick` (main thread, between ticks) folds them into a per-tick history for
+ * the overlay panel (F4) and a running summary for the benchmark reports.
+ */
+struct AiStats {
+  bool visible{false};
+
+  void record_path(u_int64_t nodes_expanded, int heap_peak, u_int64_t time_ns, bool found) {
+    path_calls.fetch_add(1, std::memory_order_relaxed);
+    if (!found) path_failures.fetch_add(1, std::memory_order_relaxed);
+    nodes.fetch_add(nodes_expanded, std::memory_order_relaxed);
+    path_time_ns.fetch_add(time_ns, std::memory_order_relaxed);
+    nodes_histogram[ai_stats_bucket(nodes_expanded)].fetch_add(1, std::memory_order_relaxed);
+
+    int peak = tick_heap_peak.load(std::memory_order_relaxed);
+    while (heap_peak > peak && !tick_heap_peak.compare_exchange_weak(peak, heap_peak, std::memory_order_relaxed)) {
+    }
+  }
+
+  void record_enemy_path_request(bool found) {
+    enemy_path_requests.fetch_add(1, std::memory_order_relaxed);
+    if (!found) enemy_no_path.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void end_tick() {
+    AiTickSample sample{};
+    sample.path_calls = static_cast<int>(path_calls.exchange(0, std::memory_order_relaxed));
+    sample.path_failures = static_cast<int>(path_failures.exchange(0, std::memory_order_relaxed));
+    sample.nodes_expanded = nodes.exchange(0, std::memory_order_relaxed);
+    sample.heap_peak = tick_heap_peak.exchange(0, std::memory_order_relaxed);
+    sample.path_ms = static_cast<float>(path_time_ns.exchange(0, std::memory_order_relaxed)) / 1e6f;
+    const u_int64_t requests = enemy_path_requests.exchange(0, std::memory_order_relaxed);
+    sample.enemy_no_path = static_cast<int>(enemy_no_path.exchange(0, std::memory_order_relaxed));
+
+    history[head] = sample;
+    head = (head + 1) % AI_STATS_WINDOW;
+    history_count = std::min(history_count + 1, AI_STATS_WINDOW);
+
+    summary.ticks++;
+    summary.path_calls += sample.path_calls;
+    summary.path_failures += sample.path_failures;
+    summary.nodes_expanded += sample.nodes_expanded;
+    summary.heap_high_water = std::max(summary.heap_high_water, sample.heap_peak);
+    summary.path_ms += sample.path_ms;
+    summary.max_tick_calls = std::max(summary.max_tick_calls, sample.path_calls);
+    summary.enemy_path_requests += requests;
+    summary.enemy_no_path += sample.enemy_no_path;
+  }
+
+  // Clears the history and the summary, e.g. at the start of a benchmark run.
+  void reset() {
+    end_tick();
+    history_count = 0;
+    head = 0;
+    summary = AiSummary{};
+    for (auto &bucket : nodes_histogram) bucket.store(0, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] AiSummary totals() const {
+    AiSummary result = summary;
+    for (int i = 0; i < AI_STATS_HISTOGRAM_BUCKETS; i++) {
+      result.nodes_histogram[i] = nodes_histogram[i].load(std::memory_order_relaxed);
+    }
+    return result;
+  }
+
+  [[nodiscard]] AiTickSample const &last_tick() const {
+    return history[(head - 1 + AI_STATS_WINDOW) % AI_STATS_WINDOW];
+  }
+
+  void toggle() {
+    visible = !visible;
+  }
+
+  // Right-aligned at `right`, growing upwards from `bottom`.
+  void draw(int right, int bottom) const {
+    if (!visible || history_count == 0) return;
+
+    AiTickSample total{};
+    AiTickSample peak{};
+    for (int i = 0; i < history_count; i++) {
+      AiTickSample const &sample = history[i];
+      total.path_calls += sample.path_calls;
+      total.path_failures += sample.path_failures;
+      total.nodes_expanded += sample.nodes_expanded;
+      total.path_ms += sample.path_ms;
+      total.enemy_no_path += sample.enemy_no_path;
+      peak.path_calls = std::max(peak.path_calls, sample.path_calls);
+      peak.heap_peak = std::max(peak.heap_peak, sample.heap_peak);
+      peak.path_ms = std::max(peak.path_ms, sample.path_ms);
+    }
+
+    const int line_h = AI_STATS_FONT_SIZE + 4;
+    const int left = right - AI_STATS_PANEL_W + 4;
+    const int top = bottom - line_h * 8;
+    DrawRectangle(left - 4, top - 4, AI_STATS_PANEL_W, line_h * 8 + 4, ColorAlpha(BLACK, 0.5f));
+
+    int y = top;
+    auto line = [&](const char *text) {
+      DrawText(text, left, y, AI_STATS_FONT_SIZE, WHITE);
+      y += line_h;
+    };
+    const float ticks = static_cast<float>(history_count);
+    line(TextFormat("AI, last %d ticks (F4)", history_count));
+    line(TextFormat("find_path / tick: %.1f avg, %d max", total.path_calls / ticks, peak.path_calls));
+    line(TextFormat("nodes / query: %.1f avg",
+                    total.path_calls > 0 ? static_cast<float>(total.nodes_expanded) / total.path_calls : 0.f));
+    line(TextFormat("path time / tick: %.3f ms avg, %.3f ms max", total.path_ms / ticks, peak.path_ms));
+    line(TextFormat("failed queries: %d, enemies without path: %d", total.path_failures, total.enemy_no_path));
+    line(TextFormat("open list high-water: %d", peak.heap_peak));
+
+    // Nodes-expanded histogram since the last reset, one bar per power of two.
+    u_int64_t max_count{1};
+    std::array<u_int64_t, AI_STATS_HISTOGRAM_BUCKETS> counts{};
+    for (int i = 0; i < AI_STATS_HISTOGRAM_BUCKETS; i++) {
+      counts[i] = nodes_histogram[i].load(std::memory_order_relaxed);
+      max_count = std::max(max_count, counts[i]);
+    }
+    const int bar_w = (AI_STATS_PANEL_W - 16) / AI_STATS_HISTOGRAM_BUCKETS;
+    for (int i = 0; i < AI_STATS_HISTOGRAM_BUCKETS; i++) {
+      const int height = static_cast<int>(counts[i] * (line_h * 2 - 2) / max_count);
+      DrawRectangle(left + i * bar_w, y + line_h * 2 - 2 - height, bar_w - 1, height, SKYBLUE);
+    }
+  }
+
+ private:
+  std::atomic<u_int64_t> path_calls{0};
+  std::atomic<u_int64_t> path_failures{0};
+  std::atomic<u_int64_t> nodes{0};
+  std::atomic<u_int64_t> path_time_ns{0};
+  std::atomic<int> tick_heap_peak{0};
+  std::atomic<u_int64_t> enemy_path_requests{0};
+  std::atomic<u_int64_t> enemy_no_path{0};
+  std::array<std::atomic<u_int64_t>, AI_STATS_HISTOGRAM_BUCKETS> nodes_histogram{};
+
+  std::array<AiTickSample, AI_STATS_WINDOW> history{};
+  int head{0};
+  int history_count{0};
+  AiSummary summary{};
+};
+
+static AiStats ai_stats{};
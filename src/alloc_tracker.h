@@ -0,0 +1,85 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Opt-in (`make profile-alloc`): replaces the global operator new and delete to count heap traffic.
+#if defined(TRACK_ALLOCATIONS)
+#define ALLOC_TRACKING_ENABLED 1
+#else
+#define ALLOC_TRACKING_ENABLED 0
+#endif
+
+struct AllocCounters {
+  u_int64_t allocs{0};
+  u_int64_t bytes{0};
+  u_int64_t frees{0};
+
+  AllocCounters operator-(AllocCounters const &rhs) const {
+    return AllocCounters{allocs - rhs.allocs, bytes - rhs.bytes, frees - rhs.frees};
+  }
+};
+
+// Of the current thread, used to attribute allocations to the zones open on it. Unused without the profiler.
+[[maybe_unused]] static thread_local AllocCounters thread_alloc_counters{};
+// Of all threads.
+static std::atomic<u_int64_t> total_allocs{0};
+static std::atomic<u_int64_t> total_alloc_bytes{0};
+static std::atomic<u_int64_t> total_frees{0};
+
+inline AllocCounters total_alloc_counters() {
+  return AllocCounters{total_allocs.load(std::memory_order_relaxed), total_alloc_bytes.load(std::memory_order_relaxed),
+                       total_frees.load(std::memory_order_relaxed)};
+}
+
+#if ALLOC_TRACKING_ENABLED
+
+inline void *tracked_alloc(std::size_t size) {
+  thread_alloc_counters.allocs++;
+  thread_alloc_counters.bytes += size;
+  total_allocs.fetch_add(1, std::memory_order_relaxed);
+  total_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+
+  void *ptr = malloc(size > 0 ? size : 1);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+inline void tracked_free(void *ptr) {
+  if (!ptr) return;
+
+  thread_alloc_counters.frees++;
+  total_frees.fetch_add(1, std::memory_order_relaxed);
+  free(ptr);
+}
+
+// Replacements of the global allocation functions. The game is a single translation unit, so defining them in a
+// header is fine. Aligned variants keep their default implementation, which they are only paired with.
+void *operator new(std::size_t size) {
+  return tracked_alloc(size);
+}
+
+void *operator new[](std::size_t size) {
+  return tracked_alloc(size);
+}
+
+void operator delete(void *ptr) noexcept {
+  tracked_free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+  tracked_free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+  tracked_free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+  tracked_free(ptr);
+}
+
+#endif
@@ -1,30 +1,44 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <cstdlib>
-#include <ctime>
 #include <list>
+#include <memory>
 
 #include "asset_manager.h"
+#include "audio.h"
+#include "autopilot.h"
+#include "bench.h"
 #include "collectibles.h"
 #include "common.h"
 #include "enemy.h"
+#include "hud.h"
+#include "input.h"
 #include "intrinsic.h"
+#include "job_system.h"
 #include "map.h"
 #include "minimap.h"
+#include "options.h"
 #include "particles.h"
 #include "path_finder.h"
 #include "player.h"
+#include "profiler.h"
 #include "raylib.h"
+#include "stress.h"
+#include "tuning.h"
 
-constexpr int ENEMY_SPAWNER_COUNT = 3;
-constexpr int MAX_COLLECTIBLE_HEALTH_COUNT = 1;
-constexpr int MAX_COLLECTIBLE_BULLET_COUNT = 5;
-constexpr int MAX_COLLECTIBLE_MINE_COUNT = 3;
-constexpr int ENEMY_JAM_CONTROL_CLOSE = CELL_DISTANCE;
-constexpr float ENEMY_JAM_CONTROL_TOO_CLOSE = CELL_DISTANCE / 2.f;
+// Smallest number of enemies worth handing to a separate thread.
+constexpr int ENEMY_UPDATE_MIN_BATCH = 16;
 
 struct App {
+  Options options;
+  Tuning tuning;
+  // Drives every gameplay and particle timer. Advanced once per tick, before the tick's phases run.
+  std::shared_ptr<TimerWheel> timer_wheel;
   std::shared_ptr<ParticleManager> particle_manager;
+  std::shared_ptr<Audio> audio;
   Player player;
   Map map{};
   std::list<Enemy> enemies{};
@@ -32,30 +46,70 @@ struct App {
   PerfChart perf_chart{};
   PathFinder path_finder{};
   Minimap minimap{};
+  Hud hud{};
   std::list<EnemySpawner> enemy_spawners{};
-  std::shared_ptr<SharedMusic> zapper_music{};
   std::list<Bullet> enemy_bullets{};
-
-  App() : particle_manager(std::make_shared<ParticleManager>()), player(particle_manager) {
+  std::unique_ptr<InputSource> input{};
+  double tick_seconds{1.0 / SIMULATION_TICK_RATE};
+  // Taken once per tick and passed down, so every phase agrees on the time.
+  FrameClock clock{};
+  JobSystem jobs;
+  TaskGraph tick_graph{};
+  InputState tick_input{};
+  std::vector<Enemy *> enemy_update_batch{};
+  std::vector<CommandBuffer> enemy_commands{};
+  int enemy_batch_count{0};
+
+  explicit App(Options _options)
+      : options(std::move(_options)),
+        tuning(options.tuning),
+        timer_wheel(std::make_shared<TimerWheel>(1.0 / options.tick_rate)),
+        particle_manager(std::make_shared<ParticleManager>(timer_wheel)),
+        audio(options.headless ? std::shared_ptr<Audio>(std::make_shared<MutedAudio>())
+                               : std::shared_ptr<Audio>(std::make_shared<RaylibAudio>())),
+        player(particle_manager, audio, timer_wheel),
+        jobs(options.threads) {
   }
 
   void init() {
-    srand(time(nullptr));
-
-    SetConfigFlags(FLAG_WINDOW_HIGHDPI | FLAG_WINDOW_RESIZABLE);
-    InitWindow(WINDOW_W, WINDOW_H, "Masacre");
-    InitAudioDevice();
-    SetTargetFPS(GetMonitorRefreshRate(0));
-    // SetTargetFPS(60);
+    seed_rngs(options.seed);
+    set_tick_rate(options.tick_rate);
+
+    if (options.headless) {
+      SetTraceLogLevel(LOG_WARNING);
+    } else {
+      SetConfigFlags(FLAG_WINDOW_HIGHDPI | FLAG_WINDOW_RESIZABLE);
+      InitWindow(WINDOW_W, WINDOW_H, "Masacre");
+      InitAudioDevice();
+      SetTargetFPS(GetMonitorRefreshRate(0));
+      // SetTargetFPS(60);
+      perf_chart.init(GetMonitorRefreshRate(0), options.perf_csv);
+      render_stats.font_texture_id = GetFontDefault().texture.id;
+    }
+    map.view_size = Vector2{WINDOW_W, WINDOW_H};
 
-    asset_manager.init();
+    asset_manager.init(jobs, options.headless);
     player.init();
     map.init();
     path_finder.init(map);
+    if (!options.headless) {
+      minimap.init(map, options.minimap_rate);
+      hud.init();
+    }
 
-    std::shared_ptr<SharedMusic> _zapper_music{
-        std::make_shared<SharedMusic>(&asset_manager.musics[ASSET_MUSIC_ZAPPER])};
-    zapper_music.swap(_zapper_music);
+    audio->init();
+
+    input = make_input(options.input);
+    build_tick_graph();
+
+    if (!options.trace_file.empty()) {
+#if PROFILER_ENABLED
+      profiler.trace_file = options.trace_file;
+      profiler.start_trace();
+#else
+      TraceLog(LOG_WARNING, "Built without the profiler (make profile), --trace is ignored");
+#endif
+    }
 
     reset();
   }
@@ -69,75 +123,412 @@ struct App {
     particle_manager->reset();
     enemy_bullets.clear();
 
-    for (int i = 0; i < ENEMY_SPAWNER_COUNT; i++)
-      enemy_spawners.emplace_back(discoverable_random_spot(), zapper_music, particle_manager);
+    for (int i = 0; i < tuning.enemy_spawner_count; i++)
+      enemy_spawners.emplace_back(discoverable_random_spot(), audio, particle_manager, timer_wheel);
+  }
+
+  // Back to tick 0: the clock, every timer and the object ids. Followed by `reset`, a seeded run replays exactly.
+  void rewind() {
+    clock = FrameClock{};
+    timer_wheel->reset();
+    global_object_id = 0;
+  }
+
+  void set_tick_rate(int ticks_per_second) {
+    tick_seconds = 1.0 / ticks_per_second;
+    timer_wheel->tick_seconds = tick_seconds;
   }
 
   void run() {
+    double accumulated_time{0.0};
+
     while (!WindowShouldClose()) {
+#if PROFILER_ENABLED
+      profiler.begin_frame();
+      if (IsKeyPressed(KEY_F2)) profiler.toggle_sort();
+      if (IsKeyPressed(KEY_F3)) profiler.toggle_trace();
+#endif
+      if (IsKeyPressed(KEY_F4)) ai_stats.toggle();
       perf_chart.register_active_frame_start();
-      update();
+      render_stats.begin_frame();
+      input->poll();
+      map.view_size = Vector2{static_cast<float>(GetScreenWidth()), static_cast<float>(GetScreenHeight())};
+
+      // Simulate in fixed steps and render the state in between the last two ticks.
+      accumulated_time += std::min(static_cast<double>(GetFrameTime()), SIMULATION_MAX_FRAME_TIME);
+      while (accumulated_time >= tick_seconds) {
+        update();
+        accumulated_time -= tick_seconds;
+      }
+      audio->stream_music();
+      map.interpolation_alpha = static_cast<float>(accumulated_time / tick_seconds);
+      {
+        PROFILE_ZONE("ui_update");
+        minimap.update(GetFrameTime(), enemies, collectibles, enemy_spawners);
+        render_stats.set_pass(RenderPass::Hud);
+        hud.update(player);
+        render_stats.set_pass(RenderPass::Other);
+      }
 
       BeginDrawing();
       ClearBackground(BLACK);
 
       draw();
-      perf_chart.register_active_frame_end();
+      render_stats.end_frame();
+      perf_chart.register_active_frame_end(render_stats.frame_totals());
 
-      EndDrawing();
+      {
+        PROFILE_ZONE("swap");
+        EndDrawing();
+      }
+#if PROFILER_ENABLED
+      profiler.counter("enemies", static_cast<double>(enemies.size()));
+      profiler.counter("particles", static_cast<double>(particle_manager->particles.size()));
+      profiler.counter("path_queries", ai_stats.last_tick().path_calls);
+      profiler.counter("path_nodes", static_cast<double>(ai_stats.last_tick().nodes_expanded));
+      profiler.counter("draw_calls", render_stats.frame_totals().draw_calls);
+      profiler.counter("texture_switches", render_stats.frame_totals().texture_switches);
+      profiler.counter("vertices", render_stats.frame_totals().vertices);
+      profiler.end_frame();
+#endif
+    }
+
+    perf_chart.finish();
+#if PROFILER_ENABLED
+    profiler.stop_trace();
+#endif
+  }
+
+  // Plays `options.matches` matches without window and audio, as fast as possible. A match lasts until the player
+  // dies or `options.max_ticks` is reached.
+  void run_headless() {
+    for (int match = 0; match < options.matches; match++) {
+      if (match > 0) reset();
+
+      auto match_start = std::chrono::steady_clock::now();
+      int tick{0};
+      while (tick < options.max_ticks && !player.is_dead()) {
+        update();
+        tick++;
+      }
+      std::chrono::duration<double, std::milli> wall_time = std::chrono::steady_clock::now() - match_start;
+
+      printf("match=%d seed=%llu ticks=%d sim_seconds=%.1f kills=%d health=%.1f enemies=%zu wall_ms=%.1f\n", match,
+             static_cast<unsigned long long>(options.seed), tick, tick * tick_seconds, player.kill_count,
+             player.health, enemies.size(), wall_time.count());
+      fflush(stdout);
     }
+
+#if PROFILER_ENABLED
+    profiler.stop_trace();
+#endif
+  }
+
+  /**
+   * Runs every benchmark scenario `options.bench_runs` times for its fixed number of ticks, as fast as possible, and
+   * writes the JSON report. Returns false when the runs of a scenario ended differently, or, with a baseline, when the
+   * gate fails: a slowdown or, unless allowed, a scenario or metric missing from the baseline.
+   */
+  bool run_bench() {
+    std::vector<BenchResult> results{};
+    bool deterministic{true};
+    for (auto const& path : options.bench_scenarios) {
+      const BenchScenario scenario = BenchScenario::from_file(path);
+      std::vector<BenchResult> runs{};
+      for (int run = 0; run < options.bench_runs; run++) runs.push_back(run_bench_scenario(scenario));
+      for (auto const& run : runs) {
+        if (run.same_outcome(runs.front())) continue;
+
+        TraceLog(LOG_ERROR, "Scenario %s ended differently between runs: kills %d/%d, health %.1f/%.1f, enemies %d/%d",
+                 scenario.name.c_str(), runs.front().kills, run.kills, runs.front().health, run.health,
+                 runs.front().final_enemies, run.final_enemies);
+        deterministic = false;
+        break;
+      }
+      results.push_back(BenchResult::median_of(std::move(runs)));
+
+      BenchResult const& result = results.back();
+      printf("scenario=%s seed=%llu ticks=%d wall_ms=%.1f tick_p50_ms=%.3f tick_p99_ms=%.3f enemies=%d\n",
+             result.scenario.name.c_str(), static_cast<unsigned long long>(result.scenario.seed),
+             result.scenario.ticks, result.wall_ms, result.tick_ms.p50, result.tick_ms.p99, result.final_enemies);
+      fflush(stdout);
+    }
+
+    write_bench_report(options.bench_report, results);
+    printf("report=%s\n", options.bench_report.c_str());
+
+    if (options.bench_baseline.empty()) return deterministic;
+
+    BenchGate gate{};
+    gate.max_slowdown = options.bench_max_slowdown;
+    gate.allow_missing = options.bench_allow_missing;
+    const int failures = gate.compare(options.bench_baseline, results);
+    printf("gate baseline=%s failures=%d\n", options.bench_baseline.c_str(), failures);
+    return deterministic && failures == 0;
+  }
+
+  // Ramps enemies, bullets and particles one kind at a time until the tick goes over budget, and writes the scaling
+  // curves to the JSON report.
+  void run_stress() {
+    const StressConfig config =
+        options.stress_config.empty() ? StressConfig{} : StressConfig::from_file(options.stress_config);
+
+    std::vector<StressCurve> curves{};
+    curves.push_back(run_stress_ramp(config, "enemies", config.enemy_step, [this](int count) {
+      while (static_cast<int>(enemies.size()) < count) {
+        enemies.emplace_back(discoverable_random_spot(), EnemyType::Regular, particle_manager, timer_wheel);
+      }
+      return static_cast<int>(enemies.size());
+    }));
+    curves.push_back(run_stress_ramp(config, "bullets", config.bullet_step, [this](int count) {
+      // Across the view, so they live until they hit a wall or leave it.
+      while (static_cast<int>(enemy_bullets.size()) < count) {
+        const float angle = gameplay_rng.range(360) * DEG2RAD;
+        const Vector2 v{cosf(angle) * BULLET_SPEED, sinf(angle) * BULLET_SPEED};
+        enemy_bullets.emplace_back(Vector2Subtract(random_view_spot(), map.world_offset), v,
+                                   BULLET_SINGLE_ATTACK_DAMAGE);
+      }
+      return static_cast<int>(enemy_bullets.size());
+    }));
+    curves.push_back(run_stress_ramp(config, "particles", config.particle_step, [this](int count) {
+      for (int i = static_cast<int>(particle_manager->particles.size()); i < count; i++) {
+        particle_manager->spawn(std::make_unique<SmokeParticle>(Vector2Subtract(random_view_spot(), map.world_offset)));
+      }
+      particle_manager->flush_spawned();
+      return static_cast<int>(particle_manager->particles.size());
+    }));
+
+    write_stress_report(options.stress_report, config, curves);
+    printf("report=%s\n", options.stress_report.c_str());
   }
 
   void update() {
-    if (IsKeyPressed(KEY_R) || IsGamepadButtonPressed(0, 5)) reset();
+    PROFILE_ZONE("update");
+    clock.advance(tick_seconds);
+    timer_wheel->advance_to(clock.tick);
 
-    particle_manager->update();
-    player.update(map);
+    tick_input = input->next_tick();
+    if (tick_input.reset) reset();
 
-    for (auto& enemy_spawner : enemy_spawners) enemy_spawner.update(enemies, player);
-    for (auto& enemy : enemies) enemy.update(*player.pos, map, path_finder, enemy_bullets);
+    tick_graph.run(jobs);
+    ai_stats.end_tick();
+  }
 
-    map.update(*player.pos);
-    zapper_music->update();
+  void draw() const {
+    PROFILE_ZONE("draw");
+    draw_world();
+    draw_ui();
+  }
 
-    update_enemy_collision_checks();
-    update_enemy_spawner_collision_checks();
-    update_collectible_collisions();
-    update_enemy_jam_control();
-    update_enemy_bullet_collisions();
+  // Sprites and shapes share the atlas, so the world batches until text or the minimap switch textures.
+  void draw_world() const {
+    PROFILE_ZONE("world");
+    render_stats.set_pass(RenderPass::Map);
+    map.draw();
+    render_stats.set_pass(RenderPass::Enemies);
+    for (auto const& enemy_spawner : enemy_spawners) enemy_spawner.draw(map);
+    for (auto const& enemy : enemies) enemy.draw(map, *player.pos);
+    render_stats.set_pass(RenderPass::Objects);
+    for (auto const& collectible : collectibles) collectible.draw(map);
+    player.draw(map);
+    for (auto const& bullet : enemy_bullets) bullet.draw(map);
+    render_stats.set_pass(RenderPass::Particles);
+    particle_manager->draw(map);
+    render_stats.set_pass(RenderPass::Other);
+    path_finder.draw(map);
+    // draw_debug_path_finding(*player.pos);
+  }
+
+  void draw_ui() const {
+    PROFILE_ZONE("ui");
+    render_stats.set_pass(RenderPass::Hud);
+    hud.draw();
+    render_stats.set_pass(RenderPass::Minimap);
+    minimap.draw(player);
+    render_stats.set_pass(RenderPass::Other);
+    perf_chart.draw();
+    render_stats.draw(4, perf_chart.top() - 4);
+    // Stacked above the HUD, which holds the same corner.
+    ai_stats.draw(GetScreenWidth() - HUD_MARGIN, hud.top() - 4);
+#if PROFILER_ENABLED
+    profiler.draw();
+#endif
+  }
+
+ private:
+  std::unique_ptr<InputSource> make_input(std::string const& source) {
+    if (!options.headless) return std::make_unique<KeyboardInput>();
 
+    if (source == "autopilot") return std::make_unique<AutopilotInput>(player, enemies);
+    if (source == "idle") return std::make_unique<ScriptedInput>();
+    return std::make_unique<ScriptedInput>(ScriptedInput::from_file(source));
+  }
+
+  BenchResult run_bench_scenario(BenchScenario const& scenario) {
+    seed_rngs(scenario.seed);
+    tuning = scenario.tuning;
+    input = make_input(scenario.input);
+    rewind();
+    reset();
+
+    BenchResult result{};
+    result.scenario = scenario;
+    result.threads = jobs.size();
+
+    std::vector<double> tick_ms{};
+    tick_ms.reserve(scenario.ticks);
+    tick_graph.timed = true;
+    tick_graph.reset_timings();
+    ai_stats.reset();
+
+    auto run_start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < scenario.ticks; tick++) {
+      auto tick_start = std::chrono::steady_clock::now();
+      update();
+      auto tick_time = std::chrono::steady_clock::now() - tick_start;
+      tick_ms.push_back(std::chrono::duration<double, std::milli>(tick_time).count());
+      result.enemy_ticks += static_cast<long long>(enemies.size());
+    }
+    result.wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - run_start).count();
+    tick_graph.timed = false;
+
+    result.tick_ms = BenchStats::of(std::move(tick_ms));
+    for (auto const& task : tick_graph.tasks) {
+      result.phase_ms.emplace_back(task->name, task->total_ms / std::max(1, scenario.ticks));
+    }
+    result.final_enemies = static_cast<int>(enemies.size());
+    result.kills = player.kill_count;
+    result.health = player.health;
+    result.ai = ai_stats.totals();
+    return result;
+  }
+
+  /**
+   * Phases of a simulation tick. Phases without a dependency path between them may run at the same time, so they must
+   * not touch the same state. Particles spawned by any phase are buffered by the particle manager until `cleanup`.
+   * Everything consuming gameplay or cosmetic randoms is on the player -> spawners -> enemies -> collisions chain,
+   * which keeps the random sequences deterministic.
+   */
+  void build_tick_graph() {
+    const int particles = tick_graph.add("particles", [this] { particle_manager->update(clock); });
+    const int player_phase = tick_graph.add("player", [this] { player.update(clock, map, tick_input); });
+    const int camera = tick_graph.add("camera", [this] { map.update(*player.pos); }, {player_phase});
+    const int spawners = tick_graph.add(
+        "spawners",
+        [this] {
+          for (auto& enemy_spawner : enemy_spawners) enemy_spawner.update(clock, enemies, player, tuning);
+        },
+        {player_phase});
+    const int enemy_phase = tick_graph.add("enemies", [this] { update_enemies(); }, {spawners});
+    const int enemy_bullet_phase = tick_graph.add("enemy_bullets", [this] { update_enemy_bullets(); }, {camera});
+    const int enemy_commands_phase =
+        tick_graph.add("enemy_commands", [this] { apply_enemy_commands(); }, {enemy_phase, enemy_bullet_phase});
+    const int collisions = tick_graph.add(
+        "collisions",
+        [this] {
+          update_enemy_collision_checks();
+          update_enemy_spawner_collision_checks();
+          update_collectible_collisions();
+          {
+            PROFILE_ZONE("jam_control");
+            update_enemy_jam_control(enemies, *player.pos);
+          }
+          update_enemy_bullet_collisions();
+        },
+        {enemy_commands_phase});
+    tick_graph.add("cleanup", [this] { update_cleanup(); }, {collisions, particles});
+    tick_graph.add("audio", [this] { audio->update(*player.pos, map); }, {collisions});
+  }
+
+  void update_cleanup() {
     // Delete disposables.
     std::erase_if(enemies, [](const auto& e) { return e.should_be_deleted(); });
     std::erase_if(collectibles, [](const auto& e) { return e.should_be_deleted; });
 
-    if (collectible_count_of_type(CollectibleType::Health) < MAX_COLLECTIBLE_HEALTH_COUNT) {
+    if (collectible_count_of_type(CollectibleType::Health) < tuning.max_health_collectibles) {
       collectibles.emplace_back(discoverable_random_spot(), CollectibleType::Health);
     }
-    if (collectible_count_of_type(CollectibleType::Bullet) < MAX_COLLECTIBLE_BULLET_COUNT) {
+    if (collectible_count_of_type(CollectibleType::Bullet) < tuning.max_bullet_collectibles) {
       collectibles.emplace_back(discoverable_random_spot(), CollectibleType::Bullet);
     }
-    if (collectible_count_of_type((CollectibleType::Mine)) < MAX_COLLECTIBLE_MINE_COUNT) {
+    if (collectible_count_of_type((CollectibleType::Mine)) < tuning.max_mine_collectibles) {
       collectibles.emplace_back(discoverable_random_spot(), CollectibleType::Mine);
     }
 
-    perf_chart.update();
+    particle_manager->flush_spawned();
   }
 
-  void draw() const {
-    map.draw();
-    for (auto const& enemy_spawner : enemy_spawners) enemy_spawner.draw(map);
-    for (auto const& enemy : enemies) enemy.draw(map, *player.pos);
-    for (auto const& collectible : collectibles) collectible.draw(map);
-    player.draw(map);
-    perf_chart.draw();
-    path_finder.draw(map);
-    minimap.draw(map, player, enemies);
-    particle_manager->draw(map);
-    for (auto const& bullet : enemy_bullets) bullet.draw(map);
-    // draw_debug_path_finding(*player.pos);
+  /**
+   * Runs `config.step_ticks` ticks at each entity count of a ramp, topping the count up before every tick with
+   * `top_up(count)`, which returns the live count. Spawners are off and the player idles and is kept alive, so only
+   * the ramped entities grow. Stops at the first count whose mean tick time is over the budget.
+   */
+  template <typename TopUp>
+  StressCurve run_stress_ramp(StressConfig const& config, const char* kind, int step, TopUp top_up) {
+    seed_rngs(options.seed);
+    tuning = options.tuning;
+    tuning.enemy_spawner_count = 0;
+    input = make_input("idle");
+    rewind();
+    reset();
+
+    StressCurve curve{};
+    curve.kind = kind;
+    tick_graph.timed = true;
+
+    for (int level = 1; level <= config.max_steps; level++) {
+      tick_graph.reset_timings();
+      std::vector<double> tick_ms{};
+      tick_ms.reserve(config.step_ticks);
+      long long live_count{0};
+
+      for (int tick = 0; tick < config.step_ticks; tick++) {
+        live_count += top_up(level * step);
+        player.health = PLAYER_MAX_HEALTH;
+
+        auto tick_start = std::chrono::steady_clock::now();
+        update();
+        auto tick_time = std::chrono::steady_clock::now() - tick_start;
+        tick_ms.push_back(std::chrono::duration<double, std::milli>(tick_time).count());
+      }
+
+      const BenchStats stats = BenchStats::of(std::move(tick_ms));
+      StressPoint point{static_cast<int>(live_count / config.step_ticks), stats.mean, stats.p95};
+      for (auto const& task : tick_graph.tasks) {
+        const double phase_ms = task->total_ms / config.step_ticks;
+        if (phase_ms > point.top_phase_ms) {
+          point.top_phase = task->name;
+          point.top_phase_ms = phase_ms;
+        }
+      }
+      curve.points.push_back(point);
+
+      printf("stress=%s count=%d tick_mean_ms=%.3f tick_p95_ms=%.3f top_phase=%s top_phase_ms=%.3f\n", kind,
+             point.count, point.tick_mean_ms, point.tick_p95_ms, point.top_phase.c_str(), point.top_phase_ms);
+      fflush(stdout);
+
+      if (point.tick_mean_ms > config.budget_ms) {
+        curve.break_count = point.count;
+        break;
+      }
+      curve.capacity = point.count;
+    }
+
+    tick_graph.timed = false;
+    if (curve.break_count > 0) {
+      printf("stress=%s capacity=%d break_count=%d\n", kind, curve.capacity, curve.break_count);
+    } else {
+      printf("stress=%s capacity=%d within budget up to max_steps\n", kind, curve.capacity);
+    }
+    return curve;
+  }
+
+  // A random position on the screen.
+  Vector2 random_view_spot() const {
+    return Vector2{static_cast<float>(gameplay_rng.range(static_cast<int>(map.view_size.x))),
+                   static_cast<float>(gameplay_rng.range(static_cast<int>(map.view_size.y)))};
   }
 
- private:
   Vector2 discoverable_random_spot() const {
     return int_vector2_to_vector2(path_finder.discoverable_random_spot());
   }
@@ -160,6 +551,30 @@ struct App {
     }
   }
 
+  // Enemies are updated in contiguous batches across the job system. Their side effects are recorded per batch and
+  // applied in enemy order afterwards (`apply_enemy_commands`), so the outcome is the same as a serial update.
+  void update_enemies() {
+    enemy_update_batch.clear();
+    for (auto& enemy : enemies) enemy_update_batch.push_back(&enemy);
+
+    const int enemy_count = static_cast<int>(enemy_update_batch.size());
+    enemy_batch_count =
+        std::clamp((enemy_count + ENEMY_UPDATE_MIN_BATCH - 1) / ENEMY_UPDATE_MIN_BATCH, 1, jobs.size());
+    if (static_cast<int>(enemy_commands.size()) < enemy_batch_count) enemy_commands.resize(enemy_batch_count);
+
+    jobs.parallel_for(enemy_count, enemy_batch_count, [&](int begin, int end, int batch) {
+      for (int i = begin; i < end; i++) {
+        enemy_update_batch[i]->update(clock, *player.pos, map, path_finder, enemy_commands[batch]);
+      }
+    });
+  }
+
+  void apply_enemy_commands() {
+    for (int batch = 0; batch < enemy_batch_count; batch++) {
+      enemy_commands[batch].apply(enemy_bullets, *particle_manager, *audio);
+    }
+  }
+
   void update_enemy_collision_checks() {
     for (auto& enemy : enemies) {
       if (enemy.is_dead) continue;
@@ -167,7 +582,7 @@ struct App {
       for (auto& bullet : player.bullets) {
         if (CheckCollisionPointCircle(bullet.pos, enemy.pos, enemy.circle_frame_radius)) {
           bullet.kill();
-          enemy.hurt(bullet);
+          enemy.hurt(bullet, clock);
           player.kill_count++;
         }
       }
@@ -179,14 +594,14 @@ struct App {
 
           for (auto& _enemy : enemies) {
             if (CheckCollisionCircles(mine.pos, mine.blast_radius(), _enemy.pos, _enemy.circle_frame_radius)) {
-              _enemy.hurt(mine);
+              _enemy.hurt(mine, clock);
             }
           }
         }
       }
 
       if (CheckCollisionCircles(*player.pos, player.circle_frame_radius, enemy.pos, enemy.circle_frame_radius)) {
-        player.hurt(enemy);
+        player.hurt(enemy, clock);
       }
     }
   }
@@ -195,7 +610,7 @@ struct App {
     for (auto& enemy_spawner : enemy_spawners) {
       for (auto& bullet : player.bullets) {
         if (CheckCollisionPointCircle(bullet.pos, enemy_spawner.pos, enemy_spawner.circle_frame_radius)) {
-          enemy_spawner.hurt(bullet);
+          enemy_spawner.hurt(bullet, clock);
           bullet.kill();
         }
       }
@@ -209,49 +624,21 @@ struct App {
         collectible.should_be_deleted = true;
         player.consume(collectible);
 
-        PlaySound(asset_manager.sounds[ASSET_SOUND_PICKUP]);
+        audio->play_sound(SoundId::Pickup);
       }
     }
   }
 
-  void update_enemy_jam_control() {
-    for (auto& enemy : enemies) enemy.collision_avoidance_slowdown = 1.f;
-    for (auto& enemy_lhs : enemies) {
-      for (auto& enemy_rhs : enemies) {
-        if (enemy_lhs.is_dead || enemy_rhs.is_dead) continue;
-        if (enemy_lhs.object_id == enemy_rhs.object_id) continue;
-
-        if (Vector2Equals(enemy_lhs.pos, enemy_rhs.pos)) {
-          if (enemy_lhs.object_id < enemy_rhs.object_id) {
-            enemy_lhs.collision_avoidance_slowdown *= 0.f;
-          } else {
-            enemy_rhs.collision_avoidance_slowdown = 0.f;
-          }
-        } else if (Vector2Distance(enemy_lhs.pos, enemy_rhs.pos) < ENEMY_JAM_CONTROL_TOO_CLOSE) {
-          if (Vector2Distance(enemy_lhs.pos, *player.pos) < Vector2Distance(enemy_rhs.pos, *player.pos)) {
-            enemy_rhs.collision_avoidance_slowdown = 0.f;
-          } else {
-            enemy_lhs.collision_avoidance_slowdown *= 0.f;
-          }
-        } else if (Vector2Distance(enemy_lhs.pos, enemy_rhs.pos) < ENEMY_JAM_CONTROL_CLOSE) {
-          if (Vector2Distance(enemy_lhs.pos, *player.pos) < Vector2Distance(enemy_rhs.pos, *player.pos)) {
-            enemy_rhs.collision_avoidance_slowdown *= 0.9f;
-          } else {
-            enemy_lhs.collision_avoidance_slowdown *= 0.9f;
-          }
-        }
-      }
-    }
+  void update_enemy_bullets() {
+    for (auto& bullet : enemy_bullets) bullet.update(map, clock);
+    std::erase_if(enemy_bullets, [](auto e) { return e.should_be_deleted; });
   }
 
   void update_enemy_bullet_collisions() {
-    for (auto& bullet : enemy_bullets) bullet.update(map);
-    std::erase_if(enemy_bullets, [](auto e) { return e.should_be_deleted; });
-
     for (auto& bullet : enemy_bullets) {
       if (CheckCollisionPointCircle(bullet.pos, *player.pos, player.circle_frame_radius)) {
         bullet.kill();
-        player.hurt(bullet);
+        player.hurt(bullet, clock);
       }
     }
   }
@@ -1,83 +1,404 @@
 #pragma once
 
-#include <unordered_map>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
+#include "job_system.h"
+#include "pak.h"
 #include "raylib.h"
+#include "render_stats.h"
 
-constexpr int ASSET_PLAYER_TEXTURE = 0;
-constexpr int ASSET_MAP_TEXTURE = 1;
-constexpr int ASSET_ENEMY_WHEEL_TEXTURE = 2;
-constexpr int ASSET_COLLECTIBLE_HEALTH_TEXTURE = 3;
-constexpr int ASSET_COLLECTIBLE_BULLET_TEXTURE = 4;
-constexpr int ASSET_ICON_HEALTH_TEXTURE = 5;
-constexpr int ASSET_ICON_BULLET_TEXTURE = 6;
-constexpr int ASSET_ICON_FPS_TEXTURE = 7;
-constexpr int ASSET_ENEMY_BARREL_TEXTURE = 8;
-constexpr int ASSET_BULLET_TEXTURE = 9;
-constexpr int ASSET_ICON_KILLS_TEXTURE = 10;
-constexpr int ASSET_PLAYER_BROKEN_TEXTURE = 11;
-constexpr int ASSET_ENEMY_BROKEN_TEXTURE = 12;
-constexpr int ASSET_COLLECTIBLE_MINE_TEXTURE = 13;
-constexpr int ASSET_ICON_MINE_TEXTURE = 14;
-constexpr int ASSET_ENEMY_SPAWNER_TEXTURE = 15;
-constexpr int ASSET_ENEMY_LARGE_WHEEL_TEXTURE = 16;
-constexpr int ASSET_ENEMY_LARGE_BARREL_TEXTURE = 17;
-constexpr int ASSET_ENEMY_LARGE_BROKEN_TEXTURE = 18;
-
-constexpr int ASSET_MAP_IMAGE = 0;
-
-constexpr int ASSET_SOUND_PLAYER_SHOOT = 0;
-constexpr int ASSET_SOUND_ENEMY_SHOOT = 1;
-constexpr int ASSET_SOUND_PICKUP = 2;
-
-constexpr int ASSET_MUSIC_ZAPPER = 0;
+enum class SpriteId {
+  Player,
+  PlayerBroken,
+  EnemyWheel,
+  EnemyBarrel,
+  EnemyBroken,
+  EnemyLargeWheel,
+  EnemyLargeBarrel,
+  EnemyLargeBroken,
+  EnemySpawner,
+  Bullet,
+  CollectibleHealth,
+  CollectibleBullet,
+  CollectibleMine,
+  IconHealth,
+  IconBullet,
+  IconMine,
+  IconKills,
+  IconFps,
+  Count,
+};
+
+enum class TextureId { Map, Count };
+enum class ImageId { Map, Count };
+enum class SoundId { PlayerShoot, EnemyShoot, Pickup, Count };
+enum class MusicId { Zapper, Count };
+
+template <typename Id>
+constexpr size_t asset_count = static_cast<size_t>(Id::Count);
+
+/**
+ * Asset storage indexed by a typed id: a lookup is a fixed offset into the array, no hashing.
+ */
+template <typename Id, typename T>
+struct AssetTable {
+  std::array<T, asset_count<Id>> items{};
+
+  T& operator[](Id id) {
+    return items[static_cast<size_t>(id)];
+  }
+  T const& operator[](Id id) const {
+    return items[static_cast<size_t>(id)];
+  }
+
+  auto begin() {
+    return items.begin();
+  }
+  auto end() {
+    return items.end();
+  }
+  auto begin() const {
+    return items.begin();
+  }
+  auto end() const {
+    return items.end();
+  }
+};
+
+template <typename Id>
+struct AssetSource {
+  Id id;
+  const char* path;
+  float volume{1.f};
+};
+
+template <typename Id>
+using AssetSources = std::array<AssetSource<Id>, asset_count<Id>>;
+
+// Every id listed exactly once, in enum order, so slot `i` of a source list loads id `i`.
+template <typename Id>
+constexpr bool lists_each_asset_once(AssetSources<Id> const& sources) {
+  for (size_t i = 0; i < sources.size(); i++) {
+    if (static_cast<size_t>(sources[i].id) != i || sources[i].path == nullptr) return false;
+    for (size_t j = 0; j < i; j++) {
+      if (std::string_view{sources[i].path} == std::string_view{sources[j].path}) return false;
+    }
+  }
+  return true;
+}
+
+// Relative to the executable's directory, also the keys of the asset archive.
+constexpr AssetSources<TextureId> TEXTURE_SOURCES{{
+    {TextureId::Map, "assets/images/map_texture.png"},
+}};
+
+constexpr AssetSources<ImageId> IMAGE_SOURCES{{
+    {ImageId::Map, "assets/images/map_image.png"},
+}};
+
+constexpr AssetSources<SpriteId> SPRITE_SOURCES{{
+    {SpriteId::Player, "assets/images/player.png"},
+    {SpriteId::PlayerBroken, "assets/images/player_broken.png"},
+    {SpriteId::EnemyWheel, "assets/images/enemy_wheel.png"},
+    {SpriteId::EnemyBarrel, "assets/images/enemy_barrel.png"},
+    {SpriteId::EnemyBroken, "assets/images/enemy_broken.png"},
+    {SpriteId::EnemyLargeWheel, "assets/images/enemy_large_wheel.png"},
+    {SpriteId::EnemyLargeBarrel, "assets/images/enemy_large_barrel.png"},
+    {SpriteId::EnemyLargeBroken, "assets/images/enemy_large_broken.png"},
+    {SpriteId::EnemySpawner, "assets/images/enemy_spawner.png"},
+    {SpriteId::Bullet, "assets/images/bullet.png"},
+    {SpriteId::CollectibleHealth, "assets/images/collectible_health.png"},
+    {SpriteId::CollectibleBullet, "assets/images/collectible_bullet.png"},
+    {SpriteId::CollectibleMine, "assets/images/collectible_mine.png"},
+    {SpriteId::IconHealth, "assets/images/icon_health.png"},
+    {SpriteId::IconBullet, "assets/images/icon_bullet.png"},
+    {SpriteId::IconMine, "assets/images/icon_mine.png"},
+    {SpriteId::IconKills, "assets/images/icon_kills.png"},
+    {SpriteId::IconFps, "assets/images/icon_fps.png"},
+}};
+
+constexpr AssetSources<SoundId> SOUND_SOURCES{{
+    {SoundId::PlayerShoot, "assets/sounds/player_shoot.mp3", 0.8f},
+    {SoundId::EnemyShoot, "assets/sounds/enemy_shoot.mp3", 0.4f},
+    {SoundId::Pickup, "assets/sounds/pickup.mp3", 0.9f},
+}};
+
+constexpr AssetSources<MusicId> MUSIC_SOURCES{{
+    {MusicId::Zapper, "assets/sounds/zapper.mp3", 1.0f},
+}};
+
+static_assert(lists_each_asset_once(TEXTURE_SOURCES), "Texture sources out of sync with TextureId");
+static_assert(lists_each_asset_once(IMAGE_SOURCES), "Image sources out of sync with ImageId");
+static_assert(lists_each_asset_once(SPRITE_SOURCES), "Sprite sources out of sync with SpriteId");
+static_assert(lists_each_asset_once(SOUND_SOURCES), "Sound sources out of sync with SoundId");
+static_assert(lists_each_asset_once(MUSIC_SOURCES), "Music sources out of sync with MusicId");
+
+// Built by `make pak`, next to the executable. Loose files are loaded when it is missing.
+constexpr const char* ASSET_PAK_FILE = "assets.pak";
+
+constexpr int ASSET_ATLAS_WIDTH = 512;
+constexpr int ASSET_ATLAS_PADDING = 2;
+// Solid white block in the atlas. Shapes are drawn with it, so they do not break the sprite batch.
+constexpr int ASSET_ATLAS_WHITE_SIZE = 4;
+
+/**
+ * A sprite within the texture atlas.
+ */
+struct Sprite {
+  Texture2D texture{};
+  Rectangle source{};
+};
 
 struct AssetManager {
-  std::unordered_map<int, Texture2D> textures{};
-  std::unordered_map<int, Image> images{};
-  std::unordered_map<int, Sound> sounds{};
-  std::unordered_map<int, Music> musics{};
+  // Standalone textures, too large for the atlas.
+  AssetTable<TextureId, Texture2D> textures{};
+  AssetTable<SpriteId, Sprite> sprites{};
+  Texture2D atlas{};
+  AssetTable<ImageId, Image> images{};
+  AssetTable<SoundId, Sound> sounds{};
+  AssetTable<MusicId, Music> musics{};
+  // Without a GPU context textures only carry their dimensions, and no sound is loaded.
+  bool headless{false};
 
   ~AssetManager() {
-    for (auto const& kv : textures) UnloadTexture(kv.second);
-    for (auto const& kv : images) UnloadImage(kv.second);
-    for (auto const& kv : sounds) UnloadSound(kv.second);
-  }
-
-  void init() {
-    textures[ASSET_PLAYER_TEXTURE] = LoadTexture("./assets/images/player.png");
-    textures[ASSET_MAP_TEXTURE] = LoadTexture("./assets/images/map_texture.png");
-    textures[ASSET_ENEMY_WHEEL_TEXTURE] = LoadTexture("./assets/images/enemy_wheel.png");
-    textures[ASSET_ENEMY_BARREL_TEXTURE] = LoadTexture("./assets/images/enemy_barrel.png");
-    textures[ASSET_COLLECTIBLE_HEALTH_TEXTURE] = LoadTexture("./assets/images/collectible_health.png");
-    textures[ASSET_COLLECTIBLE_BULLET_TEXTURE] = LoadTexture("./assets/images/collectible_bullet.png");
-    textures[ASSET_ICON_HEALTH_TEXTURE] = LoadTexture("./assets/images/icon_health.png");
-    textures[ASSET_ICON_BULLET_TEXTURE] = LoadTexture("./assets/images/icon_bullet.png");
-    textures[ASSET_ICON_FPS_TEXTURE] = LoadTexture("./assets/images/icon_fps.png");
-    textures[ASSET_BULLET_TEXTURE] = LoadTexture("./assets/images/bullet.png");
-    textures[ASSET_ICON_KILLS_TEXTURE] = LoadTexture("./assets/images/icon_kills.png");
-    textures[ASSET_PLAYER_BROKEN_TEXTURE] = LoadTexture("./assets/images/player_broken.png");
-    textures[ASSET_ENEMY_BROKEN_TEXTURE] = LoadTexture("./assets/images/enemy_broken.png");
-    textures[ASSET_COLLECTIBLE_MINE_TEXTURE] = LoadTexture("./assets/images/collectible_mine.png");
-    textures[ASSET_ICON_MINE_TEXTURE] = LoadTexture("./assets/images/icon_mine.png");
-    textures[ASSET_ENEMY_SPAWNER_TEXTURE] = LoadTexture("./assets/images/enemy_spawner.png");
-    textures[ASSET_ENEMY_LARGE_WHEEL_TEXTURE] = LoadTexture("./assets/images/enemy_large_wheel.png");
-    textures[ASSET_ENEMY_LARGE_BARREL_TEXTURE] = LoadTexture("./assets/images/enemy_large_barrel.png");
-    textures[ASSET_ENEMY_LARGE_BROKEN_TEXTURE] = LoadTexture("./assets/images/enemy_large_broken.png");
-
-    images[ASSET_MAP_IMAGE] = LoadImage("./assets/images/map_image.png");
-
-    sounds[ASSET_SOUND_PLAYER_SHOOT] = LoadSound("./assets/sounds/player_shoot.mp3");
-    SetSoundVolume(sounds[ASSET_SOUND_PLAYER_SHOOT], 0.8f);
-    sounds[ASSET_SOUND_ENEMY_SHOOT] = LoadSound("./assets/sounds/enemy_shoot.mp3");
-    SetSoundVolume(sounds[ASSET_SOUND_ENEMY_SHOOT], 0.4f);
-    sounds[ASSET_SOUND_PICKUP] = LoadSound("./assets/sounds/pickup.mp3");
-    SetSoundVolume(sounds[ASSET_SOUND_PICKUP], 0.9f);
-
-    musics[ASSET_MUSIC_ZAPPER] = LoadMusicStream("./assets/sounds/zapper.mp3");
-    SetMusicVolume(musics[ASSET_MUSIC_ZAPPER], 1.0f);
-
-    TraceLog(LOG_INFO, IsMusicValid(musics[ASSET_MUSIC_ZAPPER]) ? "VALID" : "NOT VALID");
+    for (auto const& image : images) release_image(image);
+    if (headless) return;
+
+    for (auto const& texture : textures) UnloadTexture(texture);
+    UnloadTexture(atlas);
+    for (auto const& sound : sounds) UnloadSound(sound);
+  }
+
+  /**
+   * Asset paths are relative to the executable's directory. Assets come from the memory mapped archive if there is
+   * one - already decoded - or else from the loose files, decoded in parallel on `jobs`. GPU and audio device uploads
+   * happen on the calling (main) thread.
+   */
+  void init(JobSystem& jobs, bool _headless = false) {
+    headless = _headless;
+    auto load_start = std::chrono::steady_clock::now();
+
+    base_dir = GetApplicationDirectory();
+    if (pak.open((base_dir + ASSET_PAK_FILE).c_str())) {
+      TraceLog(LOG_INFO, "Assets from archive %s%s (%d entries)", base_dir.c_str(), ASSET_PAK_FILE,
+               pak.entry_count());
+    } else {
+      TraceLog(LOG_INFO, "No asset archive, loading loose files from %s", base_dir.c_str());
+    }
+
+    std::vector<ImageLoad> image_loads{};
+    auto add_image_loads = [&](auto const& sources, ImageUse use) {
+      for (auto const& source : sources) image_loads.push_back({use, static_cast<size_t>(source.id), source.path});
+    };
+    add_image_loads(TEXTURE_SOURCES, ImageUse::GpuTexture);
+    add_image_loads(IMAGE_SOURCES, ImageUse::CpuImage);
+    add_image_loads(SPRITE_SOURCES, ImageUse::AtlasSprite);
+
+    std::vector<WaveLoad> wave_loads{};
+    if (!headless) {
+      for (auto const& source : SOUND_SOURCES) wave_loads.push_back({source.id, source.path, source.volume});
+    }
+
+    // Decode.
+    const int image_count = static_cast<int>(image_loads.size());
+    const int load_count = image_count + static_cast<int>(wave_loads.size());
+    jobs.parallel_for(load_count, load_count, [&](int begin, int end, int) {
+      for (int i = begin; i < end; i++) {
+        auto decode_start = std::chrono::steady_clock::now();
+        if (i < image_count) {
+          image_loads[i].image = load_image(image_loads[i].path);
+          image_loads[i].decode_ms = elapsed_ms(decode_start);
+        } else {
+          WaveLoad& wave_load = wave_loads[i - image_count];
+          wave_load.wave = load_wave(wave_load.path);
+          wave_load.decode_ms = elapsed_ms(decode_start);
+        }
+      }
+    });
+    const double decode_ms = elapsed_ms(load_start);
+
+    for (auto const& load : image_loads) {
+      if (!load.image.data) fail_missing(load.path);
+    }
+    for (auto const& load : wave_loads) {
+      if (!load.wave.data) fail_missing(load.path);
+    }
+
+    // Upload.
+    std::vector<std::pair<SpriteId, Image>> sprite_images{};
+    for (auto const& load : image_loads) {
+      auto upload_start = std::chrono::steady_clock::now();
+      switch (load.use) {
+        case ImageUse::GpuTexture:
+          if (headless) {
+            textures.items[load.index] = Texture2D{0, load.image.width, load.image.height, 1, load.image.format};
+          } else {
+            textures.items[load.index] = LoadTextureFromImage(load.image);
+          }
+          release_image(load.image);
+          break;
+        case ImageUse::CpuImage:
+          images.items[load.index] = load.image;
+          break;
+        case ImageUse::AtlasSprite:
+          sprite_images.emplace_back(static_cast<SpriteId>(load.index), load.image);
+          break;
+      }
+      TraceLog(LOG_INFO, "Asset %s: decode %.2f ms, upload %.2f ms", load.path, load.decode_ms,
+               elapsed_ms(upload_start));
+    }
+
+    auto atlas_start = std::chrono::steady_clock::now();
+    build_atlas(sprite_images);
+    TraceLog(LOG_INFO, "Asset atlas: pack and upload %.2f ms", elapsed_ms(atlas_start));
+
+    for (auto const& load : wave_loads) {
+      auto upload_start = std::chrono::steady_clock::now();
+      sounds[load.id] = LoadSoundFromWave(load.wave);
+      SetSoundVolume(sounds[load.id], load.volume);
+      if (!pak.contains(load.wave.data)) UnloadWave(load.wave);
+      TraceLog(LOG_INFO, "Asset %s: decode %.2f ms, upload %.2f ms", load.path, load.decode_ms,
+               elapsed_ms(upload_start));
+    }
+
+    if (!headless) {
+      // Streamed, only the decoder is opened here.
+      for (auto const& source : MUSIC_SOURCES) {
+        auto music_start = std::chrono::steady_clock::now();
+        Music& music = musics[source.id];
+        music = load_music(source.path);
+        if (!IsMusicValid(music)) fail_missing(source.path);
+        SetMusicVolume(music, source.volume);
+        TraceLog(LOG_INFO, "Asset %s: open %.2f ms", source.path, elapsed_ms(music_start));
+      }
+    }
+
+    TraceLog(LOG_INFO, "Assets loaded in %.2f ms (decode %.2f ms on %d threads)", elapsed_ms(load_start), decode_ms,
+             jobs.size());
+  }
+
+ private:
+  enum class ImageUse { GpuTexture, CpuImage, AtlasSprite };
+
+  struct ImageLoad {
+    ImageUse use;
+    // Into the table of `use`.
+    size_t index;
+    const char* path;
+    Image image{};
+    double decode_ms{};
+  };
+
+  struct WaveLoad {
+    SoundId id;
+    const char* path;
+    float volume;
+    Wave wave{};
+    double decode_ms{};
+  };
+
+  PakArchive pak{};
+  std::string base_dir{};
+
+  [[nodiscard]] std::string resolve(const char* path) const {
+    return base_dir + path;
+  }
+
+  // Thread safe, the archive is read-only once open.
+  [[nodiscard]] Image load_image(const char* path) const {
+    if (PakEntry const* entry = pak.find(path, PAK_ENTRY_IMAGE)) return pak.image(*entry);
+    return LoadImage(resolve(path).c_str());
+  }
+
+  [[nodiscard]] Wave load_wave(const char* path) const {
+    if (PakEntry const* entry = pak.find(path, PAK_ENTRY_WAVE)) return pak.wave(*entry);
+    return LoadWave(resolve(path).c_str());
+  }
+
+  // Music is streamed from the archive, which stays mapped for the lifetime of the manager.
+  [[nodiscard]] Music load_music(const char* path) const {
+    if (PakEntry const* entry = pak.find(path, PAK_ENTRY_RAW)) {
+      return LoadMusicStreamFromMemory(GetFileExtension(path), pak.payload(*entry), static_cast<int>(entry->size));
+    }
+    return LoadMusicStream(resolve(path).c_str());
+  }
+
+  void release_image(Image const& image) const {
+    if (!pak.contains(image.data)) UnloadImage(image);
+  }
+
+  [[noreturn]] static void fail_missing(const char* path) {
+    TraceLog(LOG_ERROR, "Missing asset: %s", path);
+    exit(EXIT_FAILURE);
+  }
+
+  static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  // Packs the sprites into a single texture on shelves, tallest first, so a scene is drawn in a few batches.
+  void build_atlas(std::vector<std::pair<SpriteId, Image>> sprite_images) {
+    std::stable_sort(sprite_images.begin(), sprite_images.end(),
+                     [](auto const& lhs, auto const& rhs) { return lhs.second.height > rhs.second.height; });
+
+    const Rectangle white_rect{ASSET_ATLAS_PADDING, ASSET_ATLAS_PADDING, ASSET_ATLAS_WHITE_SIZE,
+                               ASSET_ATLAS_WHITE_SIZE};
+    int x = ASSET_ATLAS_PADDING * 2 + ASSET_ATLAS_WHITE_SIZE;
+    int y = ASSET_ATLAS_PADDING;
+    int shelf_height = ASSET_ATLAS_WHITE_SIZE;
+    std::vector<Rectangle> sources{};
+    for (auto const& [id, image] : sprite_images) {
+      if (image.width > ASSET_ATLAS_WIDTH - 2 * ASSET_ATLAS_PADDING) {
+        TraceLog(LOG_ERROR, "Sprite wider than the texture atlas (%d px): %s", ASSET_ATLAS_WIDTH,
+                 SPRITE_SOURCES[static_cast<size_t>(id)].path);
+        exit(EXIT_FAILURE);
+      }
+      if (x + image.width + ASSET_ATLAS_PADDING > ASSET_ATLAS_WIDTH) {
+        x = ASSET_ATLAS_PADDING;
+        y += shelf_height + ASSET_ATLAS_PADDING;
+        shelf_height = 0;
+      }
+
+      sources.push_back(Rectangle{static_cast<float>(x), static_cast<float>(y), static_cast<float>(image.width),
+                                  static_cast<float>(image.height)});
+      x += image.width + ASSET_ATLAS_PADDING;
+      shelf_height = std::max(shelf_height, image.height);
+    }
+
+    Image atlas_image = GenImageColor(ASSET_ATLAS_WIDTH, y + shelf_height + ASSET_ATLAS_PADDING, BLANK);
+    ImageDrawRectangle(&atlas_image, ASSET_ATLAS_PADDING, ASSET_ATLAS_PADDING, ASSET_ATLAS_WHITE_SIZE,
+                       ASSET_ATLAS_WHITE_SIZE, WHITE);
+    for (unsigned int i = 0; i < sprite_images.size(); i++) {
+      Image const& image = sprite_images[i].second;
+      Rectangle image_rect{0.f, 0.f, static_cast<float>(image.width), static_cast<float>(image.height)};
+      ImageDraw(&atlas_image, image, image_rect, sources[i], WHITE);
+    }
+
+    if (headless) {
+      atlas = Texture2D{0, atlas_image.width, atlas_image.height, 1, atlas_image.format};
+    } else {
+      atlas = LoadTextureFromImage(atlas_image);
+      // Sample the middle of the white block, away from the padding.
+      SetShapesTexture(atlas, Rectangle{white_rect.x + 1.f, white_rect.y + 1.f, white_rect.width - 2.f,
+                                        white_rect.height - 2.f});
+      render_stats.shapes_texture_id = atlas.id;
+    }
+
+    for (unsigned int i = 0; i < sprite_images.size(); i++) {
+      sprites[sprite_images[i].first] = Sprite{atlas, sources[i]};
+      release_image(sprite_images[i].second);
+    }
+
+    TraceLog(LOG_INFO, "Texture atlas: %dx%d, %zu sprites", atlas_image.width, atlas_image.height,
+             sprite_images.size());
+    UnloadImage(atlas_image);
   }
 };
 
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <vector>
+
+#include "asset_manager.h"
+#include "map.h"
+#include "raylib.h"
+#include "raymath.h"
+
+// Concurrent voices per sound, in `SoundId` order. Further triggers steal the quietest voice or are dropped.
+constexpr std::array<int, asset_count<SoundId>> AUDIO_VOICE_LIMITS{
+    4,  // PlayerShoot
+    6,  // EnemyShoot
+    2,  // Pickup
+};
+// Positional sounds fade out linearly up to this distance from the listener.
+constexpr float AUDIO_MAX_DISTANCE = 900.f;
+// Quieter sounds are not worth a voice.
+constexpr float AUDIO_MIN_GAIN = 0.05f;
+// Positional sounds this far outside the view are culled.
+constexpr float AUDIO_CULL_MARGIN = 64.f;
+
+/**
+ * Sound output. Gameplay asks for sounds and music, the implementation decides what reaches the mixer. Headless runs
+ * have no audio device and use `MutedAudio`.
+ */
+struct Audio {
+  Audio() = default;
+  virtual ~Audio() = default;
+
+  // Once the assets are loaded.
+  virtual void init() = 0;
+  // Non-positional, e.g. sounds of the player itself.
+  virtual void play_sound(SoundId sound_id) = 0;
+  virtual void play_sound_at(SoundId sound_id, Vector2 pos) = 0;
+  // Looped music plays for as long as it is requested every tick.
+  virtual void request_music(MusicId music_id) = 0;
+  // Once per tick, after every phase that can play sounds.
+  virtual void update(Vector2 listener_pos, Map const& map) = 0;
+  // Once per frame on the main thread, refills the buffers of the playing music however many ticks the frame ran.
+  virtual void stream_music() = 0;
+};
+
+/**
+ * Voice manager. Every sound has a small pool of aliases sharing its samples - its voices. Triggers of a tick are
+ * collected, culled when off screen or inaudible, attenuated by distance to the listener, and assigned loudest first.
+ */
+struct RaylibAudio final : Audio {
+  ~RaylibAudio() override {
+    for (auto& pool : voices) {
+      for (auto const& voice : pool) UnloadSoundAlias(voice.sound);
+    }
+  }
+
+  void init() override {
+    for (auto const& source : SOUND_SOURCES) {
+      auto& pool = voices[source.id];
+      for (int i = 0; i < AUDIO_VOICE_LIMITS[static_cast<size_t>(source.id)]; i++) {
+        pool.push_back(Voice{LoadSoundAlias(asset_manager.sounds[source.id]), 0.f});
+      }
+    }
+  }
+
+  void play_sound(SoundId sound_id) override {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.push_back(SoundRequest{sound_id, Vector2{}, false, 1.f});
+  }
+
+  void play_sound_at(SoundId sound_id, Vector2 pos) override {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.push_back(SoundRequest{sound_id, pos, true, 1.f});
+  }
+
+  void request_music(MusicId music_id) override {
+    std::lock_guard<std::mutex> lock(mutex);
+    music_requests[music_id]++;
+  }
+
+  void update(Vector2 listener_pos, Map const& map) override {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    update_music_requests();
+
+    for (auto& request : pending) {
+      if (!request.positional) continue;
+
+      if (!map.is_visible(request.pos, AUDIO_CULL_MARGIN)) {
+        request.gain = 0.f;
+      } else {
+        request.gain = std::max(0.f, 1.f - Vector2Distance(request.pos, listener_pos) / AUDIO_MAX_DISTANCE);
+      }
+    }
+    std::erase_if(pending, [](auto const& request) { return request.gain < AUDIO_MIN_GAIN; });
+    std::stable_sort(pending.begin(), pending.end(),
+                     [](auto const& lhs, auto const& rhs) { return lhs.gain > rhs.gain; });
+
+    for (auto const& request : pending) play(request);
+    pending.clear();
+  }
+
+  void stream_music() override {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto const& source : MUSIC_SOURCES) UpdateMusicStream(asset_manager.musics[source.id]);
+  }
+
+ private:
+  struct Voice {
+    Sound sound;
+    // Of the sound it plays, or played last.
+    float gain;
+  };
+
+  struct SoundRequest {
+    SoundId id;
+    Vector2 pos;
+    bool positional;
+    float gain;
+  };
+
+  AssetTable<SoundId, std::vector<Voice>> voices{};
+  std::vector<SoundRequest> pending{};
+  AssetTable<MusicId, int> music_requests{};
+  AssetTable<MusicId, int> previous_music_requests{};
+  std::mutex mutex{};
+
+  void play(SoundRequest const& request) {
+    Voice* target{nullptr};
+    for (auto& voice : voices[request.id]) {
+      if (!IsSoundPlaying(voice.sound)) {
+        target = &voice;
+        break;
+      }
+      if (voice.gain < request.gain && (!target || voice.gain < target->gain)) target = &voice;
+    }
+    if (!target) return;
+
+    StopSound(target->sound);
+    target->gain = request.gain;
+    SetSoundVolume(target->sound, SOUND_SOURCES[static_cast<size_t>(request.id)].volume * request.gain);
+    PlaySound(target->sound);
+  }
+
+  // Starts the music requested this tick and stops the music no longer requested.
+  void update_music_requests() {
+    for (auto const& source : MUSIC_SOURCES) {
+      Music& music = asset_manager.musics[source.id];
+      int& requests = music_requests[source.id];
+      int& previous_requests = previous_music_requests[source.id];
+
+      if (requests > 0 && previous_requests == 0) {
+        PlayMusicStream(music);
+      } else if (requests == 0 && previous_requests > 0) {
+        StopMusicStream(music);
+      }
+
+      previous_requests = requests;
+      requests = 0;
+    }
+  }
+};
+
+struct MutedAudio final : Audio {
+  void init() override {
+  }
+  void play_sound(SoundId sound_id) override {
+  }
+  void play_sound_at(SoundId sound_id, Vector2 pos) override {
+  }
+  void request_music(MusicId music_id) override {
+  }
+  void update(Vector2 listener_pos, Map const& map) override {
+  }
+  void stream_music() override {
+  }
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cmath>
+#include <list>
+
+#include "common.h"
+#include "enemy.h"
+#include "input.h"
+#include "player.h"
+#include "raylib.h"
+#include "raymath.h"
+
+constexpr float AUTOPILOT_AIM_TOLERANCE_DEG = 8.f;
+constexpr float AUTOPILOT_FIRE_DISTANCE = 400.f;
+constexpr float AUTOPILOT_APPROACH_DISTANCE = 250.f;
+
+/**
+ * Simple bot for headless runs: turns towards the closest living enemy, drives closer when it is far and fires when
+ * it is aligned and in range.
+ */
+struct AutopilotInput final : InputSource {
+  Player const &player;
+  std::list<Enemy> const &enemies;
+
+  AutopilotInput(Player const &_player, std::list<Enemy> const &_enemies) : player(_player), enemies(_enemies) {
+  }
+
+  InputState next_tick() override {
+    InputState out{};
+
+    Enemy const *target = closest_enemy();
+    if (!target) return out;
+
+    float target_angle_deg = abs_angle_of_points(*player.pos, target->pos) * RAD2DEG;
+    float angle_diff = fmodf(target_angle_deg - player.target_angle, 360.f);
+    if (angle_diff > 180.f) angle_diff -= 360.f;
+    if (angle_diff < -180.f) angle_diff += 360.f;
+
+    if (angle_diff < -AUTOPILOT_AIM_TOLERANCE_DEG) out.turn_left = true;
+    if (angle_diff > AUTOPILOT_AIM_TOLERANCE_DEG) out.turn_right = true;
+
+    float dist = Vector2Distance(*player.pos, target->pos);
+    out.forward = dist > AUTOPILOT_APPROACH_DISTANCE;
+    out.rapid_fire = fabsf(angle_diff) <= AUTOPILOT_AIM_TOLERANCE_DEG && dist <= AUTOPILOT_FIRE_DISTANCE;
+
+    return out;
+  }
+
+ private:
+  Enemy const *closest_enemy() const {
+    Enemy const *closest{nullptr};
+    float closest_dist{0.f};
+
+    for (auto const &enemy : enemies) {
+      if (enemy.is_dead) continue;
+
+      float dist = Vector2Distance(*player.pos, enemy.pos);
+      if (!closest || dist < closest_dist) {
+        closest = &enemy;
+        closest_dist = dist;
+      }
+    }
+
+    return closest;
+  }
+};
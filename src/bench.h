@@ -0,0 +1,385 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ai_stats.h"
+#include "json.h"
+#include "raylib.h"
+#include "tuning.h"
+
+// Defaults of the regression gate, see `BenchGate`.
+constexpr double BENCH_GATE_MAX_SLOWDOWN = 0.05;
+constexpr double BENCH_GATE_NOISE_FACTOR = 3.0;
+constexpr double BENCH_GATE_MIN_DELTA_MS = 0.005;
+
+/**
+ * Build configuration of the running binary, recorded in the reports. Different configurations run different code, so
+ * the gate only compares reports of the same one.
+ */
+struct BenchBuild {
+  // `-O` level, set as `BUILD_OPT_LEVEL` by the bench build. Other builds only tell whether they are optimized: 0 if
+  // not, -1 for an unknown level.
+  int opt_level{0};
+  bool debug{false};
+  bool profile{false};
+  bool track_allocations{false};
+
+  static BenchBuild current() {
+    BenchBuild build{};
+#if defined(BUILD_OPT_LEVEL)
+    build.opt_level = BUILD_OPT_LEVEL;
+#elif defined(__OPTIMIZE__)
+    build.opt_level = -1;
+#endif
+#if defined(DEBUG)
+    build.debug = true;
+#endif
+#if defined(PROFILE)
+    build.profile = true;
+#endif
+#if defined(TRACK_ALLOCATIONS)
+    build.track_allocations = true;
+#endif
+    return build;
+  }
+
+  // From the `build` object of a report. Reports without one are of unknown builds and match none.
+  static BenchBuild of(JsonValue const &value) {
+    auto flag = [&](const char *key) {
+      JsonValue const *member = value.find(key);
+      return member && member->boolean;
+    };
+    return BenchBuild{static_cast<int>(value.number_or("opt_level", -2)), flag("debug"), flag("profile"),
+                      flag("track_allocations")};
+  }
+
+  bool operator==(BenchBuild const &) const = default;
+
+  [[nodiscard]] std::string describe() const {
+    std::string text = opt_level >= 0 ? "-O" + std::to_string(opt_level) : opt_level == -1 ? "-O?" : "unknown";
+    if (debug) text += " DEBUG";
+    if (profile) text += " PROFILE";
+    if (track_allocations) text += " TRACK_ALLOCATIONS";
+    return text;
+  }
+
+  void write(FILE *file) const {
+    fprintf(file, "{\"opt_level\": %d, \"debug\": %s, \"profile\": %s, \"track_allocations\": %s}", opt_level,
+            debug ? "true" : "false", profile ? "true" : "false", track_allocations ? "true" : "false");
+  }
+};
+
+/**
+ * A fixed benchmark workload, read from a `.scenario` file (see `bench/`).
+ *
+ * Settings file (see `read_settings_file`) with the keys `seed`, `ticks` and `input` (`autopilot`, `idle` or the
+ * path of an input script), plus any `Tuning` key. Unset keys keep their defaults.
+ */
+struct BenchScenario {
+  std::string name{};
+  u_int64_t seed{1};
+  int ticks{3600};
+  Tuning tuning{};
+  std::string input{"autopilot"};
+
+  static BenchScenario from_file(std::string const &path) {
+    BenchScenario scenario{};
+    scenario.name = GetFileNameWithoutExt(path.c_str());
+
+    read_settings_file(path, [&](const char *key, const char *value) {
+      if (strcmp(key, "seed") == 0) {
+        scenario.seed = strtoull(value, nullptr, 10);
+      } else if (strcmp(key, "ticks") == 0) {
+        scenario.ticks = atoi(value);
+      } else if (strcmp(key, "input") == 0) {
+        scenario.input = value;
+      } else {
+        return scenario.tuning.set(key, value);
+      }
+      return true;
+    });
+
+    if (scenario.ticks <= 0) {
+      TraceLog(LOG_ERROR, "Benchmark scenario %s needs at least one tick", path.c_str());
+      exit(EXIT_FAILURE);
+    }
+    return scenario;
+  }
+};
+
+/**
+ * Distribution of a per-tick duration in milliseconds.
+ */
+struct BenchStats {
+  double mean{};
+  double p50{};
+  double p95{};
+  double p99{};
+  double max{};
+
+  static BenchStats of(std::vector<double> values) {
+    if (values.empty()) return {};
+
+    std::sort(values.begin(), values.end());
+    auto percentile = [&](double p) {
+      return values[std::min(values.size() - 1, static_cast<size_t>(p * values.size()))];
+    };
+
+    BenchStats stats{};
+    for (double value : values) stats.mean += value;
+    stats.mean /= values.size();
+    stats.p50 = percentile(0.50);
+    stats.p95 = percentile(0.95);
+    stats.p99 = percentile(0.99);
+    stats.max = values.back();
+    return stats;
+  }
+};
+
+/**
+ * A gated timing of a scenario in milliseconds: the median over the repeated runs, and their spread (scaled median
+ * absolute deviation, comparable to a standard deviation). The spread is 0 for a single run.
+ */
+struct BenchMetric {
+  std::string name{};
+  double value{};
+  double noise{};
+
+  static BenchMetric of(std::string name, std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const double median = values[values.size() / 2];
+
+    std::vector<double> deviations{};
+    for (double value : values) deviations.push_back(fabs(value - median));
+    std::sort(deviations.begin(), deviations.end());
+    return BenchMetric{std::move(name), median, 1.4826 * deviations[deviations.size() / 2]};
+  }
+};
+
+struct BenchResult {
+  BenchScenario scenario{};
+  // Repeated runs the metrics are the median of.
+  int runs{1};
+  int threads{};
+  double wall_ms{};
+  BenchStats tick_ms{};
+  // Average time per tick of every tick phase, in graph order.
+  std::vector<std::pair<std::string, double>> phase_ms{};
+  // Sum of the live enemies over all ticks - the amount of enemy work done.
+  long long enemy_ticks{};
+  int final_enemies{};
+  int kills{};
+  float health{};
+  // Path finding and enemy AI work over the run.
+  AiSummary ai{};
+  std::vector<BenchMetric> metrics{};
+
+  // Whether two runs of a scenario ended the same way. Seeded runs must, or their timings measure different work.
+  [[nodiscard]] bool same_outcome(BenchResult const &other) const {
+    return enemy_ticks == other.enemy_ticks && final_enemies == other.final_enemies && kills == other.kills &&
+           health == other.health;
+  }
+
+  // The metrics compared against a baseline, keyed by name: the tick time distribution and every phase.
+  static std::vector<std::pair<std::string, double>> gated_values(BenchResult const &result) {
+    std::vector<std::pair<std::string, double>> values{
+        {"tick_ms.mean", result.tick_ms.mean},
+        {"tick_ms.p50", result.tick_ms.p50},
+        {"tick_ms.p95", result.tick_ms.p95},
+        {"tick_ms.p99", result.tick_ms.p99},
+    };
+    for (auto const &phase : result.phase_ms) values.emplace_back("phase_ms." + phase.first, phase.second);
+    return values;
+  }
+
+  /**
+   * Combines repeated runs of the same scenario: the run with the median mean tick time is kept for the details, and
+   * every gated metric is the median of its values over all runs.
+   */
+  static BenchResult median_of(std::vector<BenchResult> runs) {
+    std::sort(runs.begin(), runs.end(),
+              [](BenchResult const &lhs, BenchResult const &rhs) { return lhs.tick_ms.mean < rhs.tick_ms.mean; });
+    BenchResult result = runs[runs.size() / 2];
+    result.runs = static_cast<int>(runs.size());
+
+    const auto names = gated_values(result);
+    for (unsigned int metric = 0; metric < names.size(); metric++) {
+      std::vector<double> values{};
+      for (auto const &run : runs) values.push_back(gated_values(run)[metric].second);
+      result.metrics.push_back(BenchMetric::of(names[metric].first, std::move(values)));
+    }
+    return result;
+  }
+};
+
+inline void write_bench_stats(FILE *file, BenchStats const &stats) {
+  fprintf(file, "{\"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}", stats.mean, stats.p50,
+          stats.p95, stats.p99, stats.max);
+}
+
+inline void write_bench_ai(FILE *file, AiSummary const &ai) {
+  const double ticks = std::max(1, ai.ticks);
+  fprintf(file, "      \"ai\": {\"path_calls\": %llu, \"path_calls_per_tick\": %.3f, \"max_tick_path_calls\": %d, ",
+          static_cast<unsigned long long>(ai.path_calls), ai.path_calls / ticks, ai.max_tick_calls);
+  fprintf(file, "\"path_failures\": %llu, \"nodes_per_query\": %.2f, \"heap_high_water\": %d, ",
+          static_cast<unsigned long long>(ai.path_failures),
+          ai.path_calls > 0 ? static_cast<double>(ai.nodes_expanded) / ai.path_calls : 0.0, ai.heap_high_water);
+  fprintf(file, "\"path_ms_per_tick\": %.4f, \"enemy_path_requests\": %llu, \"enemy_no_path\": %llu, ",
+          ai.path_ms / ticks, static_cast<unsigned long long>(ai.enemy_path_requests),
+          static_cast<unsigned long long>(ai.enemy_no_path));
+  fprintf(file, "\"nodes_histogram_log2\": [");
+  for (int i = 0; i < AI_STATS_HISTOGRAM_BUCKETS; i++) {
+    fprintf(file, "%s%llu", i > 0 ? ", " : "", static_cast<unsigned long long>(ai.nodes_histogram[i]));
+  }
+  fprintf(file, "]},\n");
+}
+
+inline void write_bench_report(std::string const &path, std::vector<BenchResult> const &results) {
+  FILE *file = fopen(path.c_str(), "w");
+  if (!file) {
+    TraceLog(LOG_ERROR, "Cannot write benchmark report: %s", path.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  fprintf(file, "{\n  \"build\": ");
+  BenchBuild::current().write(file);
+  fprintf(file, ",\n  \"scenarios\": [\n");
+  for (unsigned int i = 0; i < results.size(); i++) {
+    BenchResult const &result = results[i];
+    // Rates stay finite for runs too short for the clock, JSON has no infinity.
+    const double wall_seconds = std::max(result.wall_ms, 1e-6) / 1000.0;
+
+    fprintf(file, "    {\n");
+    fprintf(file, "      \"name\": \"%s\",\n", result.scenario.name.c_str());
+    fprintf(file, "      \"seed\": %llu,\n", static_cast<unsigned long long>(result.scenario.seed));
+    fprintf(file, "      \"ticks\": %d,\n", result.scenario.ticks);
+    fprintf(file, "      \"threads\": %d,\n", result.threads);
+    fprintf(file, "      \"runs\": %d,\n", result.runs);
+    fprintf(file, "      \"wall_ms\": %.3f,\n", result.wall_ms);
+    fprintf(file, "      \"ticks_per_second\": %.1f,\n", result.scenario.ticks / wall_seconds);
+    fprintf(file, "      \"enemy_ticks_per_second\": %.1f,\n", result.enemy_ticks / wall_seconds);
+    fprintf(file, "      \"tick_ms\": ");
+    write_bench_stats(file, result.tick_ms);
+    fprintf(file, ",\n      \"phase_ms\": {");
+    for (unsigned int phase = 0; phase < result.phase_ms.size(); phase++) {
+      fprintf(file, "%s\"%s\": %.4f", phase > 0 ? ", " : "", result.phase_ms[phase].first.c_str(),
+              result.phase_ms[phase].second);
+    }
+    fprintf(file, "},\n");
+    fprintf(file, "      \"metrics\": {");
+    for (unsigned int metric = 0; metric < result.metrics.size(); metric++) {
+      BenchMetric const &value = result.metrics[metric];
+      fprintf(file, "%s\"%s\": {\"median\": %.4f, \"noise\": %.4f}", metric > 0 ? ", " : "", value.name.c_str(),
+              value.value, value.noise);
+    }
+    fprintf(file, "},\n");
+    write_bench_ai(file, result.ai);
+    fprintf(file, "      \"final\": {\"enemies\": %d, \"kills\": %d, \"health\": %.1f}\n", result.final_enemies,
+            result.kills, result.health);
+    fprintf(file, "    }%s\n", i + 1 < results.size() ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+
+  if (fclose(file) != 0) {
+    TraceLog(LOG_ERROR, "Cannot write benchmark report: %s", path.c_str());
+    exit(EXIT_FAILURE);
+  }
+}
+
+/**
+ * Compares benchmark results against a baseline report of the same scenarios. A metric is a regression when it grew
+ * by more than all of: `max_slowdown` of the baseline, `noise_factor` times the combined noise of both sides, and
+ * `min_delta_ms`. With repeated runs on both sides noisy metrics need a larger delta, steady ones are held tighter.
+ * A scenario or metric the baseline does not have fails the gate too, unless `allow_missing` - a stale baseline must
+ * not pass silently. Baselines of another build configuration (see `BenchBuild`) are refused.
+ */
+struct BenchGate {
+  double max_slowdown{BENCH_GATE_MAX_SLOWDOWN};
+  double noise_factor{BENCH_GATE_NOISE_FACTOR};
+  double min_delta_ms{BENCH_GATE_MIN_DELTA_MS};
+  bool allow_missing{false};
+
+  // Prints a line per compared metric and returns the number of failures: regressions and missing baselines.
+  [[nodiscard]] int compare(std::string const &baseline_path, std::vector<BenchResult> const &results) const {
+    const JsonValue baseline = read_json_file(baseline_path);
+    JsonValue const *scenarios = baseline.find("scenarios");
+    if (!scenarios || scenarios->type != JsonValue::Type::Array) {
+      TraceLog(LOG_ERROR, "Not a benchmark report: %s", baseline_path.c_str());
+      exit(EXIT_FAILURE);
+    }
+
+    JsonValue const *base_build = baseline.find("build");
+    const BenchBuild build = BenchBuild::current();
+    const BenchBuild other = base_build ? BenchBuild::of(*base_build) : BenchBuild{-2};
+    if (other != build) {
+      TraceLog(LOG_ERROR, "Baseline %s is of another build (%s) than this one (%s), not comparable",
+               baseline_path.c_str(), other.describe().c_str(), build.describe().c_str());
+      exit(EXIT_FAILURE);
+    }
+    return compare_scenarios(*scenarios, results);
+  }
+
+  // Same as `compare`, against the `scenarios` array of a parsed report.
+  [[nodiscard]] int compare_scenarios(JsonValue const &scenarios, std::vector<BenchResult> const &results) const {
+    int failures{0};
+    for (auto const &result : results) {
+      JsonValue const *base_metrics = find_scenario_metrics(scenarios, result.scenario.name);
+      if (!base_metrics) {
+        printf("gate scenario=%s not in baseline %s\n", result.scenario.name.c_str(), missing_status(failures));
+        continue;
+      }
+
+      for (auto const &metric : result.metrics) {
+        JsonValue const *base = base_metrics->find(metric.name);
+        if (!base) {
+          printf("gate scenario=%s metric=%s not in baseline %s\n", result.scenario.name.c_str(), metric.name.c_str(),
+                 missing_status(failures));
+          continue;
+        }
+
+        const double base_value = base->number_or("median", 0.0);
+        const double base_noise = base->number_or("noise", 0.0);
+        const double delta = metric.value - base_value;
+        const double threshold = std::max({max_slowdown * base_value,
+                                           noise_factor * sqrt(base_noise * base_noise + metric.noise * metric.noise),
+                                           min_delta_ms});
+
+        const char *status = "ok";
+        if (delta > threshold) {
+          status = "SLOWER";
+          failures++;
+        } else if (-delta > threshold) {
+          status = "faster";
+        }
+        printf("gate scenario=%s metric=%s baseline=%.4f current=%.4f delta=%+.1f%% threshold=%.4f %s\n",
+               result.scenario.name.c_str(), metric.name.c_str(), base_value, metric.value,
+               base_value > 0.0 ? 100.0 * delta / base_value : 0.0, threshold, status);
+      }
+    }
+    return failures;
+  }
+
+ private:
+  const char *missing_status(int &failures) const {
+    if (allow_missing) return "skipped";
+    failures++;
+    return "MISSING";
+  }
+
+  static JsonValue const *find_scenario_metrics(JsonValue const &scenarios, std::string const &name) {
+    for (auto const &scenario : scenarios.items) {
+      JsonValue const *scenario_name = scenario.find("name");
+      if (scenario_name && scenario_name->string == name) return scenario.find("metrics");
+    }
+    return nullptr;
+  }
+};
@@ -7,21 +7,26 @@
 
 struct Bullet final : AttackDamage {
   Vector2 pos{};
-  Vector2 v{};
+  Vector2 prev_pos{};
+  Vector2 v{};  // Pixel per second.
   bool should_be_deleted{false};
   float angle_deg{};
 
-  Bullet(Vector2 _pos, Vector2 _v, float _attack_damage) : AttackDamage(_attack_damage), pos(_pos), v(_v) {
+  Bullet(Vector2 _pos, Vector2 _v, float _attack_damage)
+      : AttackDamage(_attack_damage), pos(_pos), prev_pos(_pos), v(_v) {
     angle_deg = abs_angle_of_points(Vector2(), v) * RAD2DEG;
   }
 
   void draw(Map const &map) const {
-    draw_texture(asset_manager.textures[ASSET_BULLET_TEXTURE], Vector2Add(pos, map.world_offset), angle_deg);
+    if (!map.is_visible(pos, asset_manager.sprites[SpriteId::Bullet].source.width)) return;
+
+    draw_sprite(asset_manager.sprites[SpriteId::Bullet], map.to_screen(prev_pos, pos), angle_deg);
   }
 
-  void update(Map const &map) {
-    pos.x += v.x;
-    pos.y += v.y;
+  void update(Map const &map, FrameClock const &clock) {
+    prev_pos = pos;
+    pos.x += v.x * clock.dt;
+    pos.y += v.y * clock.dt;
 
     if (!should_be_deleted) {
       if (map.is_hit(pos)) {
@@ -29,7 +34,7 @@ struct Bullet final : AttackDamage {
       } else {
         Vector2 rel_pos = get_rel_pos(map.world_offset);
         should_be_deleted |=
-            rel_pos.x < 0.f || rel_pos.y < 0.f || rel_pos.x > GetScreenWidth() || rel_pos.y > GetScreenHeight();
+            rel_pos.x < 0.f || rel_pos.y < 0.f || rel_pos.x > map.view_size.x || rel_pos.y > map.view_size.y;
       }
     }
   }
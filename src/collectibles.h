@@ -22,26 +22,28 @@ struct Collectible {
   float circle_frame_radius;
 
   Collectible(Vector2 _pos, CollectibleType _ty) : pos(_pos), ty(_ty) {
-    circle_frame_radius = asset_manager.textures[ASSET_COLLECTIBLE_HEALTH_TEXTURE].width / 2.f;
+    circle_frame_radius = asset_manager.sprites[SpriteId::CollectibleHealth].source.width / 2.f;
   }
 
   void draw(Map const& map) const {
-    int texture_id;
+    if (!map.is_visible(pos, circle_frame_radius)) return;
+
+    SpriteId sprite_id;
     switch (ty) {
       case CollectibleType::Bullet:
-        texture_id = ASSET_COLLECTIBLE_BULLET_TEXTURE;
+        sprite_id = SpriteId::CollectibleBullet;
         break;
       case CollectibleType::Health:
-        texture_id = ASSET_COLLECTIBLE_HEALTH_TEXTURE;
+        sprite_id = SpriteId::CollectibleHealth;
         break;
       case CollectibleType::Mine:
-        texture_id = ASSET_COLLECTIBLE_MINE_TEXTURE;
+        sprite_id = SpriteId::CollectibleMine;
         break;
       default:
         TraceLog(LOG_ERROR, "Unhandled collectible type");
         exit(EXIT_FAILURE);
     }
 
-    draw_texture(asset_manager.textures[texture_id], Vector2Add(pos, map.world_offset), 0.f);
+    draw_sprite(asset_manager.sprites[sprite_id], map.to_screen(pos), 0.f);
   }
 };
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "audio.h"
+#include "bullet.h"
+#include "particles.h"
+#include "raylib.h"
+
+enum class ParticleKind { Smoke };
+
+struct ParticleSpawn {
+  ParticleKind kind;
+  Vector2 pos;
+};
+
+struct SoundSpawn {
+  SoundId id;
+  Vector2 pos;
+};
+
+/**
+ * Side effects recorded by an update running on a worker thread. Nothing shared is touched until `apply` runs on the
+ * main thread, buffers are applied in a fixed order so the result does not depend on thread scheduling.
+ */
+struct CommandBuffer {
+  std::vector<Bullet> bullets{};
+  std::vector<ParticleSpawn> particles{};
+  std::vector<SoundSpawn> sounds{};
+
+  void spawn_bullet(Bullet const &bullet) {
+    bullets.push_back(bullet);
+  }
+
+  void spawn_particle(ParticleKind kind, Vector2 pos) {
+    particles.push_back(ParticleSpawn{kind, pos});
+  }
+
+  void play_sound(SoundId sound_id, Vector2 pos) {
+    sounds.push_back(SoundSpawn{sound_id, pos});
+  }
+
+  void apply(std::list<Bullet> &target_bullets, ParticleManager &particle_manager, Audio &audio) {
+    for (auto const &bullet : bullets) target_bullets.push_back(bullet);
+
+    for (auto const &spawn : particles) {
+      switch (spawn.kind) {
+        case ParticleKind::Smoke:
+          particle_manager.spawn(std::make_unique<SmokeParticle>(spawn.pos));
+          break;
+        default:
+          TraceLog(LOG_ERROR, "Unhandled particle kind");
+          exit(EXIT_FAILURE);
+      }
+    }
+
+    for (auto const &sound : sounds) audio.play_sound_at(sound.id, sound.pos);
+
+    clear();
+  }
+
+  void clear() {
+    bullets.clear();
+    particles.clear();
+    sounds.clear();
+  }
+};
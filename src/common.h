@@ -6,6 +6,9 @@
 #include "map.h"
 #include "raylib.h"
 #include "raymath.h"
+#include "render_stats.h"
+#include "rng.h"
+#include "timer_wheel.h"
 
 #define XY(vector2) vector2.x, vector2.y
 
@@ -16,14 +19,33 @@ constexpr int CELL_DISTANCE = 50;
 constexpr int REFERENCE_FPS = 144;
 constexpr float BULLET_SINGLE_ATTACK_DAMAGE = 30.f;
 constexpr float BULLET_BURST_ATTACK_DAMAGE = 10.f;
+constexpr int SIMULATION_TICK_RATE = 60;
+// Real time a single rendered frame may feed into the simulation. Caps the catch-up work after a long hitch.
+constexpr double SIMULATION_MAX_FRAME_TIME = 0.25;
 
-static u_int64_t global_object_id{0};
+[[maybe_unused]] static u_int64_t global_object_id{0};
+
+/**
+ * Simulation time of the current tick, passed down the update paths. It only moves forward by whole ticks, so every
+ * update sees the same fixed `dt` regardless of the render rate.
+ */
+struct FrameClock {
+  double now{0.0};
+  float dt{1.f / SIMULATION_TICK_RATE};
+  u_int64_t tick{0};
+
+  void advance(double tick_seconds) {
+    dt = static_cast<float>(tick_seconds);
+    now += tick_seconds;
+    tick++;
+  }
+};
 
 /**
  * Returns a random between 0.0 and 1.0 (both included).
  */
-inline float randf() {
-  return static_cast<float>(rand() % 1001) / 1000.f;
+inline float randf(Rng &rng) {
+  return static_cast<float>(rng.range(1001)) / 1000.f;
 }
 
 struct Deletable {
@@ -35,13 +57,14 @@ struct UIElement {
   virtual ~UIElement() = default;
 
   virtual void draw(Map const &map) const = 0;
-  virtual void update() = 0;
+  virtual void update(FrameClock const &clock) = 0;
 };
 
 struct UIElementAndDeletable : UIElement, Deletable {};
 
 struct AttackDamage {
-  [[nodiscard]] virtual float get_attack_damage() const {
+  // Continuous damagers scale with the tick length.
+  [[nodiscard]] virtual float get_attack_damage(FrameClock const &) const {
     return attack_damage;
   }
 
@@ -71,12 +94,12 @@ inline Vector2 int_vector2_to_vector2(IntVector2 p) {
   return Vector2{static_cast<float>(p.x * CELL_DISTANCE), static_cast<float>(p.y * CELL_DISTANCE)};
 }
 
-float randf_balanced(float v, float jitter) {
-  return v + randf() * jitter - (jitter / 2.f);
+float randf_balanced(Rng &rng, float v, float jitter) {
+  return v + randf(rng) * jitter - (jitter / 2.f);
 }
 
-Vector2 randomize_pos(Vector2 const &p, float jitter) {
-  return Vector2{randf_balanced(p.x, jitter), randf_balanced(p.y, jitter)};
+Vector2 randomize_pos(Rng &rng, Vector2 const &p, float jitter) {
+  return Vector2{randf_balanced(rng, p.x, jitter), randf_balanced(rng, p.y, jitter)};
 }
 
 struct PFCell {
@@ -96,95 +119,171 @@ struct PFCell {
   }
 };
 
+/**
+ * One-shot timer on the central `TimerWheel`. Completion is flagged by the wheel, checking it is a plain read.
+ */
 struct TimedTask {
   double lifetime_seconds;
-  double lifetime_end{};
 
-  TimedTask(double _lifetime_seconds) : lifetime_seconds(_lifetime_seconds) {
+  // Armed right away.
+  TimedTask(TimerWheel &_wheel, double _lifetime_seconds) : lifetime_seconds(_lifetime_seconds), wheel(&_wheel) {
+    reset();
+  }
+
+  // Armed by `start`, for owners that do not know the wheel when created (particles).
+  explicit TimedTask(double _lifetime_seconds) : lifetime_seconds(_lifetime_seconds) {
+  }
+
+  TimedTask(TimedTask const &) = delete;
+  TimedTask &operator=(TimedTask const &) = delete;
+
+  ~TimedTask() {
+    cancel();
+  }
+
+  // `expiry_flag` is set by the wheel once the task completes.
+  void start(TimerWheel &_wheel, bool *expiry_flag = nullptr) {
+    wheel = &_wheel;
+    state.expiry_flag = expiry_flag;
     reset();
   }
 
-  bool is_completed() const {
-    return GetTime() > lifetime_end;
+  [[nodiscard]] bool is_completed() const {
+    return state.expired;
   }
 
   void reset() {
-    lifetime_end = GetTime() + lifetime_seconds;
+    cancel();
+    state.expired = false;
+    handle = wheel->schedule(&state, wheel->ticks_from_seconds(lifetime_seconds));
   }
 
   void reset(double _lifetime_seconds) {
     lifetime_seconds = _lifetime_seconds;
     reset();
   }
+
+ private:
+  TimerWheel *wheel{nullptr};
+  TimerWheel::Handle handle{};
+  TimerState state{};
+
+  void cancel() {
+    if (wheel) wheel->cancel(handle);
+  }
 };
 
+/**
+ * Repeating timer on the central `TimerWheel`. The wheel re-arms it on every expiry, `did_tick` only compares the tick
+ * of the last expiry.
+ */
 struct RepeatedTask {
-  double interval_seconds;
-  bool did_tick{false};
   bool is_paused{false};
-  double additional_jitter{0.f};
-  double current_jitter{0.f};
-  double last_tick;
 
-  explicit RepeatedTask(double _interval_seconds) : interval_seconds(_interval_seconds), last_tick(GetTime()) {
-    update_jitter();
+  RepeatedTask(TimerWheel &_wheel, double _interval_seconds)
+      : wheel(&_wheel), start_tick(_wheel.now()), initial_interval_seconds(_interval_seconds) {
+    state.repeating = true;
+    state.interval_seconds = _interval_seconds;
+    arm();
   }
 
-  explicit RepeatedTask(double _interval_seconds, double _additional_jitter)
-      : interval_seconds(_interval_seconds), additional_jitter(_additional_jitter), last_tick(GetTime()) {
-    update_jitter();
+  RepeatedTask(TimerWheel &_wheel, double _interval_seconds, double _additional_jitter)
+      : wheel(&_wheel),
+        start_tick(_wheel.now()),
+        initial_interval_seconds(_interval_seconds),
+        jitter_rng(gameplay_rng.fork()) {
+    state.repeating = true;
+    state.interval_seconds = _interval_seconds;
+    state.jitter_seconds = _additional_jitter;
+    state.jitter_rng = &jitter_rng;
+    arm();
+  }
+
+  RepeatedTask(RepeatedTask const &) = delete;
+  RepeatedTask &operator=(RepeatedTask const &) = delete;
+
+  ~RepeatedTask() {
+    wheel->cancel(handle);
   }
 
   void pause() {
+    if (is_paused) return;
+
     is_paused = true;
+    wheel->cancel(handle);
   }
 
   void resume() {
+    if (!is_paused) return;
+
     is_paused = false;
+    arm();
   }
 
   void set_interval(double _interval_seconds) {
-    interval_seconds = _interval_seconds;
-  }
-
-  bool update() {
-    did_tick = false;
-
-    if (is_paused) return did_tick;
-
-    if (last_tick + interval_seconds + current_jitter < GetTime()) {
-      did_tick = true;
-      last_tick = GetTime();
+    if (state.interval_seconds == _interval_seconds) return;
 
-      if (additional_jitter > 0.f) update_jitter();
+    state.interval_seconds = _interval_seconds;
+    if (!is_paused) {
+      wheel->cancel(handle);
+      arm();
     }
+  }
+
+  // Starts over as if created in the current tick: first interval, a new jitter stream, not paused.
+  void restart() {
+    wheel->cancel(handle);
+    is_paused = false;
+    start_tick = wheel->now();
+    state.last_fired_tick = TIMER_NEVER;
+    state.expired = false;
+    state.interval_seconds = initial_interval_seconds;
+    if (state.jitter_rng) jitter_rng = gameplay_rng.fork();
+    arm();
+  }
 
-    return did_tick;
+  // Whether the task came due in the current tick.
+  [[nodiscard]] bool did_tick() const {
+    return !is_paused && state.last_fired_tick == wheel->now();
   }
 
  private:
-  void update_jitter() {
-    current_jitter = randf() * additional_jitter;
+  TimerWheel *wheel;
+  TimerWheel::Handle handle{};
+  TimerState state{};
+  u_int64_t start_tick;
+  double initial_interval_seconds;
+  // Own stream, so the jitter sequence does not depend on what else consumed gameplay randoms in between.
+  Rng jitter_rng{};
+
+  // Next expiry counts from the last one, as if pausing or changing the interval never interrupted the period.
+  void arm() {
+    double jitter = state.jitter_rng ? jitter_rng.unit() * state.jitter_seconds : 0.0;
+    u_int64_t last_tick = state.last_fired_tick == TIMER_NEVER ? start_tick : state.last_fired_tick;
+    u_int64_t due_tick = last_tick + wheel->ticks_from_seconds(state.interval_seconds + jitter);
+    handle = wheel->schedule(&state, due_tick > wheel->now() ? due_tick - wheel->now() : 1);
   }
 };
 
 struct TimedRepeatedTask {
   RepeatedTask repeater;
-  TimedTask timer{0.0};
+  TimedTask timer;
 
-  TimedRepeatedTask(double _interval_seconds) : repeater(_interval_seconds) {
+  TimedRepeatedTask(TimerWheel &wheel, double _interval_seconds)
+      : repeater(wheel, _interval_seconds), timer(wheel, 0.0) {
   }
 
   void start_timer(double seconds) {
     timer.reset(seconds);
   }
 
-  bool update() {
-    if (timer.is_completed()) {
-      return false;
-    } else {
-      return repeater.update();
-    }
+  void restart() {
+    repeater.restart();
+    timer.reset(0.0);
+  }
+
+  [[nodiscard]] bool did_tick() const {
+    return !timer.is_completed() && repeater.did_tick();
   }
 };
 
@@ -240,43 +339,17 @@ std::vector<IntVector2> ordered_cell_indices_from_coord(Vector2 const &p) {
   return out;
 }
 
-// Draws texture at the center point as origin.
-void draw_texture(Texture2D const &texture, Vector2 const &pos, float angle_deg) {
-  DrawTexturePro(texture, {0.f, 0.f, (float)texture.width, (float)texture.height},
-                 {pos.x, pos.y, (float)texture.width, (float)texture.height},
-                 Vector2{texture.width / 2.f, texture.height / 2.f}, angle_deg, WHITE);
+// Draws sprite at the center point as origin.
+void draw_sprite(Sprite const &sprite, Vector2 const &pos, float angle_deg) {
+  DrawTexturePro(sprite.texture, sprite.source, {pos.x, pos.y, sprite.source.width, sprite.source.height},
+                 Vector2{sprite.source.width / 2.f, sprite.source.height / 2.f}, angle_deg, WHITE);
+  render_stats.quads(sprite.texture.id);
 }
 
-float fps_independent_multiplier() {
-  return static_cast<float>(REFERENCE_FPS) / static_cast<float>(GetFPS());
+float fps_independent_multiplier(float dt) {
+  return static_cast<float>(REFERENCE_FPS) * dt;
 }
 
-void fps_independent_multiply(float *v, float mul) {
-  *v *= powf(mul, fps_independent_multiplier());
+void fps_independent_multiply(float *v, float mul, float dt) {
+  *v *= powf(mul, fps_independent_multiplier(dt));
 }
-
-struct SharedMusic {
-  Music *music;
-  int requests{0};
-  int previous_requests{0};
-
-  SharedMusic(Music *_music) : music(_music) {
-  }
-
-  void request() {
-    requests++;
-  }
-
-  void update() {
-    UpdateMusicStream(*music);
-
-    if (requests > 0 && previous_requests == 0) {
-      PlayMusicStream(*music);
-    } else if (requests == 0 && previous_requests > 0) {
-      StopMusicStream(*music);
-    }
-
-    previous_requests = requests;
-    requests = 0;
-  }
-};
@@ -4,13 +4,16 @@
 #include <memory>
 
 #include "asset_manager.h"
+#include "audio.h"
 #include "bullet.h"
+#include "command_buffer.h"
 #include "common.h"
 #include "map.h"
 #include "particles.h"
 #include "path_finder.h"
 #include "player.h"
 #include "raylib.h"
+#include "tuning.h"
 #include "zapper.h"
 
 constexpr float ENEMY_SPEED = 200.f;
@@ -18,35 +21,51 @@ constexpr float ENEMY_TARGET_REACH_THRESHOLD = 1.f;
 constexpr float ENEMY_EXPLOSION_SPEED = 200.f;
 constexpr float ENEMY_PLAYER_MIN_CHASE_DISTANCE = 100.f;
 constexpr float ENEMY_SPAWNER_MAX_HEALTH = 800.f;
+constexpr int ENEMY_JAM_CONTROL_CLOSE = CELL_DISTANCE;
+constexpr float ENEMY_JAM_CONTROL_TOO_CLOSE = CELL_DISTANCE / 2.f;
 
 enum class EnemyType { Regular, Large };
 
 struct Enemy final : AttackDamage {
+  // First, so the timers below are cancelled while the wheel is still alive.
+  std::shared_ptr<TimerWheel> timer_wheel;
   u_int64_t object_id;
   Vector2 pos;
+  Vector2 prev_pos;
   Vector2 move_target{};
   float circle_frame_radius{};
   float angle{};
   bool is_dead{false};
-  TimedTask dying_lifetime{2.0};
-  RepeatedTask shooting_task{2.0, 2.0};
+  TimedTask dying_lifetime;
+  RepeatedTask shooting_task;
   std::shared_ptr<ParticleManager> particle_manager;
   float barrel_angle_rad{};
   float collision_avoidance_slowdown{1.f};
-  RepeatedTask smoke_particle_scheduler{1.0f};
+  RepeatedTask smoke_particle_scheduler;
   float health;
   EnemyType ty;
-
-  explicit Enemy(Vector2 _pos, EnemyType _ty, std::shared_ptr<ParticleManager> _particle_manager)
-      : pos(_pos), move_target(_pos), particle_manager(std::move(_particle_manager)), ty(_ty) {
+  Rng rng;
+
+  explicit Enemy(Vector2 _pos, EnemyType _ty, std::shared_ptr<ParticleManager> _particle_manager,
+                 std::shared_ptr<TimerWheel> _timer_wheel)
+      : timer_wheel(std::move(_timer_wheel)),
+        pos(_pos),
+        prev_pos(_pos),
+        move_target(_pos),
+        dying_lifetime(*timer_wheel, 2.0),
+        shooting_task(*timer_wheel, 2.0, 2.0),
+        particle_manager(std::move(_particle_manager)),
+        smoke_particle_scheduler(*timer_wheel, 1.0),
+        ty(_ty),
+        rng(gameplay_rng.fork()) {
     // The frame is derived from the image which is designed for turning.
     // Once the turning works, let's reduce the wheel size so we can use it to assume a frame size.
     switch (ty) {
       case EnemyType::Regular:
-        circle_frame_radius = wheel_texture().width / 3.f;
+        circle_frame_radius = wheel_texture().source.width / 3.f;
         break;
       case EnemyType::Large:
-        circle_frame_radius = wheel_texture().width / 2.f;
+        circle_frame_radius = wheel_texture().source.width / 2.f;
         break;
       default:
         TraceLog(LOG_ERROR, "Unexpected enemy type");
@@ -59,45 +78,50 @@ struct Enemy final : AttackDamage {
     smoke_particle_scheduler.pause();
   }
 
-  void update(Vector2 const &player_pos, Map const &map, PathFinder const &path_finder,
-              std::list<Bullet> &enemy_bullets) {
+  // Runs on worker threads: shared state is only read, side effects go to `commands`.
+  void update(FrameClock const &clock, Vector2 const &player_pos, Map const &map, PathFinder const &path_finder,
+              CommandBuffer &commands) {
+    prev_pos = pos;
+
     if (!is_dead) {
       if (Vector2Distance(pos, move_target) <= ENEMY_TARGET_REACH_THRESHOLD) {
         update_move_target(player_pos, map, path_finder);
       } else {
-        update_movement_towards_target(player_pos);
+        update_movement_towards_target(player_pos, clock.dt);
       }
 
       barrel_angle_rad = abs_angle_of_points(pos, player_pos);
 
       // Shoot the player.
-      if (shooting_task.did_tick) {
-        float aim_jitter_rad = ((rand() % 31) - 15) * DEG2RAD;
-        Vector2 bullet_v{cosf(barrel_angle_rad + aim_jitter_rad) * BULLET_SPEED * GetFrameTime(),
-                         sinf(barrel_angle_rad + aim_jitter_rad) * BULLET_SPEED * GetFrameTime()};
-        enemy_bullets.emplace_back(pos, bullet_v, BULLET_SINGLE_ATTACK_DAMAGE);
-
-        PlaySound(asset_manager.sounds[ASSET_SOUND_ENEMY_SHOOT]);
+      if (shooting_task.did_tick()) {
+        float aim_jitter_rad = (rng.range(31) - 15) * DEG2RAD;
+        Vector2 bullet_v{cosf(barrel_angle_rad + aim_jitter_rad) * BULLET_SPEED,
+                         sinf(barrel_angle_rad + aim_jitter_rad) * BULLET_SPEED};
+        commands.spawn_bullet(Bullet(pos, bullet_v, BULLET_SINGLE_ATTACK_DAMAGE));
+        commands.play_sound(SoundId::EnemyShoot, pos);
       }
     }
-    shooting_task.update();
 
-    if (smoke_particle_scheduler.update()) particle_manager->particles.push_back(std::make_unique<SmokeParticle>(pos));
+    if (smoke_particle_scheduler.did_tick()) commands.spawn_particle(ParticleKind::Smoke, pos);
   }
 
   void draw(Map const &map, Vector2 const &player_pos) const {
+    // The barrel reaches beyond the wheel.
+    if (!map.is_visible(pos, circle_frame_radius * 2.f)) return;
+
     if (is_dead) {
-      draw_texture(broken_texture(), Vector2Add(pos, map.world_offset), angle);
+      draw_sprite(broken_texture(), map.to_screen(prev_pos, pos), angle);
     } else {
-      draw_texture(wheel_texture(), Vector2Add(pos, map.world_offset), angle);
-      draw_texture(barrel_texture(), Vector2Add(pos, map.world_offset), barrel_angle_rad * RAD2DEG);
+      Vector2 screen_pos = map.to_screen(prev_pos, pos);
+      draw_sprite(wheel_texture(), screen_pos, angle);
+      draw_sprite(barrel_texture(), screen_pos, barrel_angle_rad * RAD2DEG);
     }
   }
 
-  void hurt(AttackDamage const &damager) {
+  void hurt(AttackDamage const &damager, FrameClock const &clock) {
     if (is_dead) return;
 
-    health -= damager.get_attack_damage();
+    health -= damager.get_attack_damage(clock);
 
     if (health <= 0.f) {
       health = 0.f;
@@ -114,43 +138,43 @@ struct Enemy final : AttackDamage {
     return is_dead && dying_lifetime.is_completed();
   }
 
-  [[nodiscard]] float get_attack_damage() const override {
+  [[nodiscard]] float get_attack_damage(FrameClock const &clock) const override {
     if (is_dead) return 0.f;
 
-    return 10.f * GetFrameTime();
+    return 10.f * clock.dt;
   }
 
  private:
-  Texture2D &wheel_texture() const {
+  Sprite &wheel_texture() const {
     switch (ty) {
       case EnemyType::Regular:
-        return asset_manager.textures[ASSET_ENEMY_WHEEL_TEXTURE];
+        return asset_manager.sprites[SpriteId::EnemyWheel];
       case EnemyType::Large:
-        return asset_manager.textures[ASSET_ENEMY_LARGE_WHEEL_TEXTURE];
+        return asset_manager.sprites[SpriteId::EnemyLargeWheel];
       default:
         TraceLog(LOG_ERROR, "Unexpected enemy type");
         exit(EXIT_FAILURE);
     }
   }
 
-  Texture2D &barrel_texture() const {
+  Sprite &barrel_texture() const {
     switch (ty) {
       case EnemyType::Regular:
-        return asset_manager.textures[ASSET_ENEMY_BARREL_TEXTURE];
+        return asset_manager.sprites[SpriteId::EnemyBarrel];
       case EnemyType::Large:
-        return asset_manager.textures[ASSET_ENEMY_LARGE_BARREL_TEXTURE];
+        return asset_manager.sprites[SpriteId::EnemyLargeBarrel];
       default:
         TraceLog(LOG_ERROR, "Unexpected enemy type");
         exit(EXIT_FAILURE);
     }
   }
 
-  Texture2D &broken_texture() const {
+  Sprite &broken_texture() const {
     switch (ty) {
       case EnemyType::Regular:
-        return asset_manager.textures[ASSET_ENEMY_BROKEN_TEXTURE];
+        return asset_manager.sprites[SpriteId::EnemyBroken];
       case EnemyType::Large:
-        return asset_manager.textures[ASSET_ENEMY_LARGE_BROKEN_TEXTURE];
+        return asset_manager.sprites[SpriteId::EnemyLargeBroken];
       default:
         TraceLog(LOG_ERROR, "Unexpected enemy type");
         exit(EXIT_FAILURE);
@@ -161,6 +185,7 @@ struct Enemy final : AttackDamage {
     if (Vector2Distance(pos, player_pos) <= ENEMY_PLAYER_MIN_CHASE_DISTANCE) return;
 
     auto path = path_finder.find_path(pos, player_pos);
+    ai_stats.record_enemy_path_request(!path.empty());
     if (path.empty()) {
       TraceLog(LOG_INFO, "No path from enemy to player");
       return;
@@ -172,12 +197,12 @@ struct Enemy final : AttackDamage {
     move_target = Vector2(path[path.size() - 2].x * CELL_DISTANCE, path[path.size() - 2].y * CELL_DISTANCE);
   }
 
-  void update_movement_towards_target(Vector2 const &player_pos) {
+  void update_movement_towards_target(Vector2 const &player_pos, float dt) {
     if (Vector2Distance(pos, player_pos) <= ENEMY_PLAYER_MIN_CHASE_DISTANCE) return;
 
     Vector2 delta = Vector2Subtract(pos, move_target);
     float total_dist = Vector2Distance(pos, move_target);
-    float move_dist = speed() * GetFrameTime() * collision_avoidance_slowdown;
+    float move_dist = speed() * dt * collision_avoidance_slowdown;
 
     Vector2 old_pos{pos};
 
@@ -216,42 +241,84 @@ struct Enemy final : AttackDamage {
   }
 };
 
+// Slows down enemies bumping into each other, the one farther from the player gives way.
+void update_enemy_jam_control(std::list<Enemy> &enemies, Vector2 const &player_pos) {
+  for (auto &enemy : enemies) enemy.collision_avoidance_slowdown = 1.f;
+  for (auto &enemy_lhs : enemies) {
+    for (auto &enemy_rhs : enemies) {
+      if (enemy_lhs.is_dead || enemy_rhs.is_dead) continue;
+      if (enemy_lhs.object_id == enemy_rhs.object_id) continue;
+
+      if (Vector2Equals(enemy_lhs.pos, enemy_rhs.pos)) {
+        if (enemy_lhs.object_id < enemy_rhs.object_id) {
+          enemy_lhs.collision_avoidance_slowdown *= 0.f;
+        } else {
+          enemy_rhs.collision_avoidance_slowdown = 0.f;
+        }
+      } else if (Vector2Distance(enemy_lhs.pos, enemy_rhs.pos) < ENEMY_JAM_CONTROL_TOO_CLOSE) {
+        if (Vector2Distance(enemy_lhs.pos, player_pos) < Vector2Distance(enemy_rhs.pos, player_pos)) {
+          enemy_rhs.collision_avoidance_slowdown = 0.f;
+        } else {
+          enemy_lhs.collision_avoidance_slowdown *= 0.f;
+        }
+      } else if (Vector2Distance(enemy_lhs.pos, enemy_rhs.pos) < ENEMY_JAM_CONTROL_CLOSE) {
+        if (Vector2Distance(enemy_lhs.pos, player_pos) < Vector2Distance(enemy_rhs.pos, player_pos)) {
+          enemy_rhs.collision_avoidance_slowdown *= 0.9f;
+        } else {
+          enemy_lhs.collision_avoidance_slowdown *= 0.9f;
+        }
+      }
+    }
+  }
+}
+
 struct EnemySpawner {
+  std::shared_ptr<TimerWheel> timer_wheel;
   Vector2 pos;
-  std::shared_ptr<SharedMusic> zapper_music;
-  RepeatedTask spawn_repeater{5.0};
+  std::shared_ptr<Audio> audio;
+  RepeatedTask spawn_repeater;
   float circle_frame_radius{30.f};
   float health{ENEMY_SPAWNER_MAX_HEALTH};
-  RepeatedTask smoke_repeater{1.f};
+  RepeatedTask smoke_repeater;
   std::shared_ptr<ParticleManager> particle_manager;
   Zapper zapper{};
 
-  EnemySpawner(Vector2 _pos, std::shared_ptr<SharedMusic> _zapper_music,
-               std::shared_ptr<ParticleManager> _particle_manager)
-      : pos(_pos), zapper_music(std::move(_zapper_music)), particle_manager(std::move(_particle_manager)) {
+  EnemySpawner(Vector2 _pos, std::shared_ptr<Audio> _audio, std::shared_ptr<ParticleManager> _particle_manager,
+               std::shared_ptr<TimerWheel> _timer_wheel)
+      : timer_wheel(std::move(_timer_wheel)),
+        pos(_pos),
+        audio(std::move(_audio)),
+        spawn_repeater(*timer_wheel, ENEMY_SPAWN_INTERVAL),
+        smoke_repeater(*timer_wheel, 1.0),
+        particle_manager(std::move(_particle_manager)) {
     smoke_repeater.pause();
   }
 
-  void update(std::list<Enemy> &enemies, Player &player) {
+  void update(FrameClock const &clock, std::list<Enemy> &enemies, Player &player, Tuning const &tuning) {
     const bool player_too_close = Vector2Distance(pos, *player.pos) <= 196.f;
     zapper.visible = player_too_close;
     zapper.start = pos;
     zapper.end = *player.pos;
 
+    spawn_repeater.set_interval(tuning.spawn_interval);
+
     if (!is_dead()) {
-      if (spawn_repeater.update()) {
-        enemies.emplace_back(pos, rand() % 10 == 0 ? EnemyType::Large : EnemyType::Regular, particle_manager);
+      const bool at_capacity = tuning.max_enemies > 0 && static_cast<int>(enemies.size()) >= tuning.max_enemies;
+      if (spawn_repeater.did_tick() && !at_capacity) {
+        const bool large = tuning.large_enemy_one_in > 0 && gameplay_rng.range(tuning.large_enemy_one_in) == 0;
+        EnemyType enemy_type = large ? EnemyType::Large : EnemyType::Regular;
+        enemies.emplace_back(pos, enemy_type, particle_manager, timer_wheel);
         // enemies.emplace_back(pos, EnemyType::Large);
       }
 
       if (player_too_close) {
-        zapper_music->request();
-        player.hurt(zapper);
+        audio->request_music(MusicId::Zapper);
+        player.hurt(zapper, clock);
       }
     }
 
-    if (smoke_repeater.update()) {
-      particle_manager->particles.push_back(std::make_unique<SmokeParticle>(pos, circle_frame_radius));
+    if (smoke_repeater.did_tick()) {
+      particle_manager->spawn(std::make_unique<SmokeParticle>(pos, circle_frame_radius));
     }
   }
 
@@ -260,19 +327,22 @@ struct EnemySpawner {
       zapper.draw(map);
     }
 
-    draw_texture(asset_manager.textures[ASSET_ENEMY_SPAWNER_TEXTURE], Vector2Add(pos, map.world_offset), 0.f);
-    DrawRectangle(pos.x - circle_frame_radius + map.world_offset.x - 2.f,
-                  pos.y - circle_frame_radius - 8 + map.world_offset.y - 2.f, (circle_frame_radius * 2) + 4.f,
-                  8.f + 4.f, DARKGRAY);
-    DrawRectangle(pos.x - circle_frame_radius + map.world_offset.x,
-                  pos.y - circle_frame_radius - 8 + map.world_offset.y,
+    // Health bar included.
+    if (!map.is_visible(pos, circle_frame_radius + 12.f)) return;
+
+    Vector2 screen_pos = map.to_screen(pos);
+    draw_sprite(asset_manager.sprites[SpriteId::EnemySpawner], screen_pos, 0.f);
+    DrawRectangle(screen_pos.x - circle_frame_radius - 2.f, screen_pos.y - circle_frame_radius - 8 - 2.f,
+                  (circle_frame_radius * 2) + 4.f, 8.f + 4.f, DARKGRAY);
+    DrawRectangle(screen_pos.x - circle_frame_radius, screen_pos.y - circle_frame_radius - 8,
                   (circle_frame_radius * 2) * health / ENEMY_SPAWNER_MAX_HEALTH, 8.f, RED);
+    render_stats.shape_quads(2);
   }
 
-  void hurt(AttackDamage const &damager) {
+  void hurt(AttackDamage const &damager, FrameClock const &clock) {
     if (is_dead()) return;
 
-    health -= damager.get_attack_damage();
+    health -= damager.get_attack_damage(clock);
     if (health <= 0.f) {
       health = 0.f;
       smoke_repeater.pause();
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "asset_manager.h"
+#include "player.h"
+#include "raylib.h"
+#include "render_stats.h"
+
+constexpr int HUD_W = 140;
+constexpr int HUD_H = 100;
+// Distance from the bottom right corner of the screen.
+constexpr int HUD_MARGIN = 4;
+
+/**
+ * Values shown by the HUD. It is only re-rendered when they change.
+ */
+struct HudValues {
+  int health_bar{-1};
+  int kill_count{-1};
+  int bullet_count{-1};
+  int mine_count{-1};
+  int fps{-1};
+
+  bool operator==(HudValues const &other) const = default;
+};
+
+/**
+ * Player stats panel, composited into a render texture. A frame only draws the cached texture.
+ */
+struct Hud {
+  ~Hud() {
+    if (target.id > 0) UnloadRenderTexture(target);
+  }
+
+  void init() {
+    target = LoadRenderTexture(HUD_W, HUD_H);
+  }
+
+  // Must be called outside of `BeginDrawing` / `EndDrawing`.
+  void update(Player const &player) {
+    HudValues values{static_cast<int>((player.health / PLAYER_MAX_HEALTH) * 100.f), player.kill_count,
+                     player.bullet_count, player.mine_count, GetFPS()};
+    if (values == shown) return;
+
+    shown = values;
+    render();
+  }
+
+  [[nodiscard]] int top() const {
+    return GetScreenHeight() - HUD_H - HUD_MARGIN;
+  }
+
+  void draw() const {
+    // Render textures are stored upside down.
+    DrawTextureRec(target.texture, Rectangle{0.f, 0.f, HUD_W, -HUD_H},
+                   Vector2{static_cast<float>(GetScreenWidth() - HUD_W - HUD_MARGIN), static_cast<float>(top())},
+                   WHITE);
+    render_stats.quads(target.texture.id);
+  }
+
+ private:
+  RenderTexture2D target{};
+  HudValues shown{};
+
+  void render() const {
+    BeginTextureMode(target);
+    render_stats.flush();
+    ClearBackground(ColorAlpha(DARKGRAY, 0.9f));
+
+    // Health bar.
+    DrawRectangle(32, 8, shown.health_bar, 12, RED);
+    DrawRectangleLinesEx(Rectangle{28.f, 4.f, 108.f, 20.f}, 2.f, WHITE);
+    render_stats.shape_quads(1 + 4);
+    draw_icon(SpriteId::IconHealth, 4, 4);
+
+    // Kill bar.
+    draw_icon(SpriteId::IconKills, 4, 28);
+    draw_text(TextFormat("%d", shown.kill_count), 28, 28);
+
+    // Bullet bar.
+    draw_icon(SpriteId::IconBullet, 4, 52);
+    draw_text(TextFormat("%d", shown.bullet_count), 28, 52);
+
+    // Mine bar.
+    draw_icon(SpriteId::IconMine, 70, 52);
+    draw_text(TextFormat("%d", shown.mine_count), 94, 52);
+
+    // FPS bar.
+    draw_icon(SpriteId::IconFps, 4, 76);
+    draw_text(TextFormat("%d FPS", shown.fps), 28, 76);
+
+    render_stats.flush();
+    EndTextureMode();
+  }
+
+  static void draw_icon(SpriteId sprite_id, int x, int y) {
+    Sprite const &sprite = asset_manager.sprites[sprite_id];
+    DrawTextureRec(sprite.texture, sprite.source, Vector2{static_cast<float>(x), static_cast<float>(y)}, WHITE);
+    render_stats.quads(sprite.texture.id);
+  }
+
+  static void draw_text(const char *text, int x, int y) {
+    DrawText(text, x, y, 20, WHITE);
+    render_stats.text(text);
+  }
+};
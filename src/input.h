@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "raylib.h"
+
+/**
+ * Player controls for a single simulation tick.
+ */
+struct InputState {
+  bool forward{false};
+  bool backward{false};
+  bool turn_left{false};
+  bool turn_right{false};
+  float turn_axis{0.f};
+  bool rapid_fire{false};
+
+  // Edge triggered actions.
+  bool shoot{false};
+  bool drop_mine{false};
+  bool reset{false};
+};
+
+/**
+ * Source of the player controls. The simulation asks for exactly one `InputState` per tick.
+ */
+struct InputSource {
+  InputSource() = default;
+  virtual ~InputSource() = default;
+
+  // Called once per rendered frame. Headless runs never call it.
+  virtual void poll() {
+  }
+
+  virtual InputState next_tick() = 0;
+};
+
+/**
+ * Keyboard and gamepad input, sampled once per rendered frame.
+ *
+ * The simulation runs at a fixed tick rate, so a frame can run zero or several ticks. Held keys are simply sampled,
+ * while presses are latched until the next tick consumes them - this way a press is neither lost nor repeated.
+ */
+struct KeyboardInput final : InputSource {
+  InputState state{};
+
+  void poll() override {
+    state.forward = IsKeyDown(KEY_UP);
+    state.backward = IsKeyDown(KEY_DOWN);
+    state.turn_left = IsKeyDown(KEY_LEFT);
+    state.turn_right = IsKeyDown(KEY_RIGHT);
+    state.turn_axis = IsGamepadAvailable(0) ? GetGamepadAxisMovement(0, GAMEPAD_AXIS_LEFT_X) : 0.f;
+    state.rapid_fire = IsKeyDown(KEY_LEFT_ALT) || IsGamepadButtonDown(0, 8);
+
+    state.shoot |= IsKeyPressed(KEY_LEFT_CONTROL) || IsGamepadButtonPressed(0, 7);
+    state.drop_mine |= IsKeyPressed(KEY_LEFT_SHIFT);
+    state.reset |= IsKeyPressed(KEY_R) || IsGamepadButtonPressed(0, 5);
+  }
+
+  InputState next_tick() override {
+    InputState out = state;
+
+    state.shoot = false;
+    state.drop_mine = false;
+    state.reset = false;
+
+    return out;
+  }
+};
+
+/**
+ * Replays a looping script of timed control steps.
+ *
+ * Script format, one step per line: `<ticks> [action ...]`, where actions are `forward`, `backward`, `left`,
+ * `right`, `rapid_fire`, `shoot` and `mine`. Edge triggered actions fire on the first tick of the step only.
+ * Empty lines and lines starting with `#` are ignored.
+ */
+struct ScriptedInput final : InputSource {
+  struct Step {
+    int ticks{};
+    InputState state{};
+  };
+
+  std::vector<Step> steps{};
+  unsigned int step_idx{0};
+  int step_tick{0};
+
+  ScriptedInput() = default;
+  explicit ScriptedInput(std::vector<Step> _steps) : steps(std::move(_steps)) {
+  }
+
+  static ScriptedInput from_file(std::string const &path) {
+    FILE *file = fopen(path.c_str(), "r");
+    if (!file) {
+      TraceLog(LOG_ERROR, "Cannot open input script: %s", path.c_str());
+      exit(EXIT_FAILURE);
+    }
+
+    std::vector<Step> steps{};
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+      if (line[0] == '#' || line[0] == '\n') continue;
+
+      Step step{};
+      char *token = strtok(line, " \t\r\n");
+      if (!token) continue;
+      step.ticks = atoi(token);
+
+      while ((token = strtok(nullptr, " \t\r\n"))) {
+        if (strcmp(token, "forward") == 0) {
+          step.state.forward = true;
+        } else if (strcmp(token, "backward") == 0) {
+          step.state.backward = true;
+        } else if (strcmp(token, "left") == 0) {
+          step.state.turn_left = true;
+        } else if (strcmp(token, "right") == 0) {
+          step.state.turn_right = true;
+        } else if (strcmp(token, "rapid_fire") == 0) {
+          step.state.rapid_fire = true;
+        } else if (strcmp(token, "shoot") == 0) {
+          step.state.shoot = true;
+        } else if (strcmp(token, "mine") == 0) {
+          step.state.drop_mine = true;
+        } else {
+          TraceLog(LOG_ERROR, "Unknown input script action: %s", token);
+          exit(EXIT_FAILURE);
+        }
+      }
+
+      if (step.ticks > 0) steps.push_back(step);
+    }
+    fclose(file);
+
+    return ScriptedInput(std::move(steps));
+  }
+
+  InputState next_tick() override {
+    if (steps.empty()) return {};
+
+    InputState out = steps[step_idx].state;
+    if (step_tick > 0) {
+      out.shoot = false;
+      out.drop_mine = false;
+    }
+
+    if (++step_tick >= steps[step_idx].ticks) {
+      step_tick = 0;
+      step_idx = (step_idx + 1) % steps.size();
+    }
+
+    return out;
+  }
+};
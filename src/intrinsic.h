@@ -3,73 +3,188 @@
 #include <raylib.h>
 
 #include <algorithm>
-#include <deque>
+#include <array>
+#include <cstdio>
+#include <string>
+#include <utility>
+
+#include "render_stats.h"
 
 constexpr int PERF_CHART_MAX_VALUES = 100;
 constexpr float PERF_CHART_BAR_HEIGHT = 80.f;
 constexpr float PERF_CHART_BAR_WIDTH = 4.f;
-constexpr int PERF_SAMPLE_RATE = 4;
+// Statistics to the right of the bars, frame and CPU time side by side.
+constexpr int PERF_CHART_TEXT_WIDTH = 160;
+// Frames the statistics are computed over.
+constexpr int PERF_WINDOW = 1024;
+// Frames between two statistics updates.
+constexpr int PERF_STATS_INTERVAL = 30;
+// A frame is a hitch when it takes this many times the target frame time.
+constexpr float PERF_HITCH_FACTOR = 2.f;
+
+struct PerfSample {
+  // Update and draw, up to the buffer swap.
+  float cpu_ms;
+  // Start of the frame to the start of the next one, including the swap and waiting for vsync.
+  float frame_ms;
+  RenderCounters render;
+};
+
+struct PerfPercentiles {
+  float p50{};
+  float p95{};
+  float p99{};
+  float max{};
+};
+
+struct PerfStats {
+  PerfPercentiles frame{};
+  PerfPercentiles cpu{};
+  int hitches{};
+};
 
+/**
+ * Frame time chart and statistics. Keeps the raw time of the last `PERF_WINDOW` frames, and derives the frame time
+ * and CPU time percentiles and the hitches from them. Every frame can also be written to a CSV file, to compare frame
+ * pacing across builds and machines.
+ */
 struct PerfChart {
-  std::deque<float> values{};
-  float active_frame_start{};
-  float accumulated_time{0.f};
-  int sample_count{0};
+  ~PerfChart() {
+    if (csv) fclose(csv);
+  }
+
+  void init(int target_fps, std::string const &csv_path) {
+    hitch_ms = target_fps > 0 ? PERF_HITCH_FACTOR * 1000.f / target_fps : 0.f;
+    if (csv_path.empty()) return;
+
+    csv = fopen(csv_path.c_str(), "w");
+    if (!csv) {
+      TraceLog(LOG_WARNING, "Cannot write frame times: %s", csv_path.c_str());
+      return;
+    }
+    fprintf(csv, "frame,cpu_ms,frame_ms,draw_calls,texture_switches,vertices,flushes\n");
+  }
 
   void register_active_frame_start() {
-    active_frame_start = GetTime();
+    const double now = GetTime();
+    if (frame_start > 0.0) {
+      add(PerfSample{static_cast<float>((active_frame_end - frame_start) * 1000.0),
+                     static_cast<float>((now - frame_start) * 1000.0), frame_render});
+    }
+    frame_start = now;
   }
 
-  void register_active_frame_end() {
-    accumulated_time += GetTime() - active_frame_start;
-    sample_count++;
+  // Just before the buffer swap, with the render cost of the frame.
+  void register_active_frame_end(RenderCounters const &render) {
+    active_frame_end = GetTime();
+    frame_render = render;
+  }
 
-    if (sample_count >= PERF_SAMPLE_RATE) {
-      values.push_back(accumulated_time / PERF_SAMPLE_RATE);
-      accumulated_time = 0.f;
-      sample_count = 0;
+  // Logs the final statistics and closes the CSV file.
+  void finish() {
+    if (frame_count > 0) {
+      update_stats();
+      TraceLog(LOG_INFO, "Frame times over the last %d frames: p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms",
+               std::min(frame_count, PERF_WINDOW), stats.frame.p50, stats.frame.p95, stats.frame.p99, stats.frame.max);
+      TraceLog(LOG_INFO, "CPU times over the last %d frames: p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms",
+               std::min(frame_count, PERF_WINDOW), stats.cpu.p50, stats.cpu.p95, stats.cpu.p99, stats.cpu.max);
+      TraceLog(LOG_INFO, "Hitches: %d of %d frames", total_hitches, frame_count);
     }
+
+    if (csv) fclose(csv);
+    csv = nullptr;
   }
 
-  void update() {
-    ensure_capacity();
+  [[nodiscard]] PerfStats const &frame_stats() const {
+    return stats;
   }
 
-  void draw() const {
-    if (values.empty()) return;
+  // Top edge of the chart, panels shown alongside stack above it.
+  [[nodiscard]] int top() const {
+    return GetScreenHeight() - 12 - static_cast<int>(PERF_CHART_BAR_HEIGHT);
+  }
 
-    float _min = min();
-    float _max = max();
-    float _min_adjusted = min() * 0.9f;
-    float _max_adjusted = max() * 1.1f;
+  void draw() const {
+    const int shown = std::min(frame_count, PERF_CHART_MAX_VALUES);
+    if (shown == 0) return;
 
-    int offset = PERF_CHART_MAX_VALUES - values.size();
+    const float scale_ms = std::max(stats.frame.max, hitch_ms) * 1.1f;
+    const float bottom = GetScreenHeight() - 8.f;
 
-    DrawRectangle(4, GetScreenHeight() - 12 - PERF_CHART_BAR_HEIGHT,
-                  PERF_CHART_MAX_VALUES * PERF_CHART_BAR_WIDTH + 8 + 80, PERF_CHART_BAR_HEIGHT + 8,
+    DrawRectangle(4, top(),
+                  PERF_CHART_MAX_VALUES * PERF_CHART_BAR_WIDTH + 8 + PERF_CHART_TEXT_WIDTH, PERF_CHART_BAR_HEIGHT + 8,
                   ColorAlpha(BLACK, 0.4));
-    for (unsigned int i = 0; i < values.size(); i++) {
-      float height = ((values[i] - _min_adjusted) / (_max_adjusted - _min_adjusted)) * PERF_CHART_BAR_HEIGHT;
-      DrawRectangle(8.f + ((offset + i) * PERF_CHART_BAR_WIDTH), GetScreenHeight() - 8.f - height, PERF_CHART_BAR_WIDTH,
-                    height, MAROON);
+    for (int i = 0; i < shown; i++) {
+      PerfSample const &sample = samples[(head - shown + i + PERF_WINDOW) % PERF_WINDOW];
+      const float x = 8.f + (PERF_CHART_MAX_VALUES - shown + i) * PERF_CHART_BAR_WIDTH;
+      const float frame_height = std::min(sample.frame_ms / scale_ms, 1.f) * PERF_CHART_BAR_HEIGHT;
+      const float cpu_height = std::min(sample.cpu_ms / scale_ms, 1.f) * PERF_CHART_BAR_HEIGHT;
+
+      DrawRectangle(x, bottom - frame_height, PERF_CHART_BAR_WIDTH, frame_height,
+                    hitch_ms > 0.f && sample.frame_ms > hitch_ms ? RED : GRAY);
+      DrawRectangle(x, bottom - cpu_height, PERF_CHART_BAR_WIDTH, cpu_height, MAROON);
     }
 
-    DrawText(TextFormat("%.2f ms", _max * 1000), 12 + PERF_CHART_MAX_VALUES * PERF_CHART_BAR_WIDTH,
-             GetScreenHeight() - 8 - PERF_CHART_BAR_HEIGHT, 20, WHITE);
-    DrawText(TextFormat("%.2f ms", _min * 1000), 12 + PERF_CHART_MAX_VALUES * PERF_CHART_BAR_WIDTH,
-             GetScreenHeight() - 28, 20, WHITE);
+    const int text_x = 12 + PERF_CHART_MAX_VALUES * PERF_CHART_BAR_WIDTH;
+    const int text_top = GetScreenHeight() - 8 - PERF_CHART_BAR_HEIGHT;
+    const int cpu_x = text_x + PERF_CHART_TEXT_WIDTH / 2;
+    DrawText("frame", text_x + 24, text_top, 10, GRAY);
+    DrawText("cpu", cpu_x, text_top, 10, MAROON);
+    const std::array<std::pair<const char *, float PerfPercentiles::*>, 4> rows{
+        {{"p50", &PerfPercentiles::p50}, {"p95", &PerfPercentiles::p95}, {"p99", &PerfPercentiles::p99},
+         {"max", &PerfPercentiles::max}}};
+    for (int i = 0; i < static_cast<int>(rows.size()); i++) {
+      const int y = text_top + 14 * (i + 1);
+      DrawText(TextFormat("%s %.2f ms", rows[i].first, stats.frame.*rows[i].second), text_x, y, 10, WHITE);
+      DrawText(TextFormat("%.2f ms", stats.cpu.*rows[i].second), cpu_x, y, 10, WHITE);
+    }
+    DrawText(TextFormat("hitches %d / %d", stats.hitches, std::min(frame_count, PERF_WINDOW)), text_x, text_top + 70,
+             10, WHITE);
   }
 
  private:
-  [[nodiscard]] float min() const {
-    return std::ranges::min(values);
+  std::array<PerfSample, PERF_WINDOW> samples{};
+  int head{0};
+  int frame_count{0};
+  int total_hitches{0};
+  float hitch_ms{0.f};
+  double frame_start{0.0};
+  double active_frame_end{0.0};
+  RenderCounters frame_render{};
+  PerfStats stats{};
+  FILE *csv{nullptr};
+
+  void add(PerfSample const &sample) {
+    samples[head] = sample;
+    head = (head + 1) % PERF_WINDOW;
+    frame_count++;
+    if (hitch_ms > 0.f && sample.frame_ms > hitch_ms) total_hitches++;
+
+    if (csv) {
+      fprintf(csv, "%d,%.3f,%.3f,%d,%d,%d,%d\n", frame_count, sample.cpu_ms, sample.frame_ms, sample.render.draw_calls,
+              sample.render.texture_switches, sample.render.vertices, sample.render.flushes);
+    }
+    if (frame_count % PERF_STATS_INTERVAL == 0 || frame_count < PERF_STATS_INTERVAL) update_stats();
   }
 
-  [[nodiscard]] float max() const {
-    return std::ranges::max(values);
+  void update_stats() {
+    const int count = std::min(frame_count, PERF_WINDOW);
+    std::array<float, PERF_WINDOW> frame_ms{};
+    std::array<float, PERF_WINDOW> cpu_ms{};
+    stats.hitches = 0;
+    for (int i = 0; i < count; i++) {
+      frame_ms[i] = samples[i].frame_ms;
+      cpu_ms[i] = samples[i].cpu_ms;
+      if (hitch_ms > 0.f && frame_ms[i] > hitch_ms) stats.hitches++;
+    }
+    stats.frame = percentiles(frame_ms, count);
+    stats.cpu = percentiles(cpu_ms, count);
   }
 
-  void ensure_capacity() {
-    if (values.size() > PERF_CHART_MAX_VALUES) values.pop_front();
+  // Of the first `count` values, which are sorted in place.
+  static PerfPercentiles percentiles(std::array<float, PERF_WINDOW> &values, int count) {
+    std::sort(values.begin(), values.begin() + count);
+    auto percentile = [&](float p) { return values[std::min(count - 1, static_cast<int>(p * count))]; };
+    return PerfPercentiles{percentile(0.50f), percentile(0.95f), percentile(0.99f), values[count - 1]};
   }
 };
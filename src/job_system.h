@@ -0,0 +1,257 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "profiler.h"
+
+// Job system and queue the current thread works for.
+struct JobThreadBinding {
+  void const *owner{nullptr};
+  int queue_idx{0};
+};
+
+static thread_local JobThreadBinding job_thread_binding{};
+
+/**
+ * Work stealing job system.
+ *
+ * Every thread - the owner (the thread constructing it) and the workers - has its own job queue. Threads take jobs
+ * from the back of their own queue and steal from the front of the others when it runs dry. Waiting for jobs never
+ * blocks: the waiting thread keeps executing jobs, so jobs may submit and wait for other jobs.
+ */
+struct JobSystem {
+  using Job = std::function<void()>;
+
+  explicit JobSystem(int thread_count) : queues(std::max(1, thread_count)) {
+    bind_current_thread(0);
+    for (int i = 1; i < static_cast<int>(queues.size()); i++) threads.emplace_back([this, i] { worker_loop(i); });
+  }
+
+  JobSystem(JobSystem const &) = delete;
+  JobSystem &operator=(JobSystem const &) = delete;
+
+  ~JobSystem() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex);
+      stopping = true;
+    }
+    sleep_cv.notify_all();
+    for (auto &thread : threads) thread.join();
+  }
+
+  [[nodiscard]] int size() const {
+    return static_cast<int>(queues.size());
+  }
+
+  void submit(Job job) {
+    Queue &queue = queues[current_queue_index()];
+    {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.jobs.push_back(std::move(job));
+    }
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex);
+      queued_jobs++;
+    }
+    sleep_cv.notify_one();
+  }
+
+  // Executes jobs on the calling thread until `remaining` drops to zero.
+  void wait(std::atomic<int> const &remaining) {
+    const int queue_idx = current_queue_index();
+    while (remaining.load(std::memory_order_acquire) > 0) {
+      if (!run_one(queue_idx)) std::this_thread::yield();
+    }
+  }
+
+  /**
+   * Splits [0, count) into `chunk_count` contiguous ranges and calls `fn(begin, end, chunk)` for each of them as
+   * separate jobs. Returns once every chunk is done. Chunk boundaries only depend on the arguments, never on
+   * scheduling. Each chunk is profiled under the zone open on the calling thread, whichever thread runs it.
+   */
+  void parallel_for(int count, int chunk_count, std::function<void(int, int, int)> const &fn) {
+    if (chunk_count <= 1 || threads.empty()) {
+      for (int chunk = 0; chunk < chunk_count; chunk++) {
+        fn(chunk_begin(count, chunk_count, chunk), chunk_begin(count, chunk_count, chunk + 1), chunk);
+      }
+      return;
+    }
+
+#if PROFILER_ENABLED
+    const int parent_zone = profile_current_zone;
+#endif
+    std::atomic<int> remaining{chunk_count};
+    for (int chunk = 1; chunk < chunk_count; chunk++) {
+      submit([&, chunk] {
+        {
+          PROFILE_ZONE_UNDER("parallel_for", parent_zone);
+          fn(chunk_begin(count, chunk_count, chunk), chunk_begin(count, chunk_count, chunk + 1), chunk);
+        }
+        remaining.fetch_sub(1, std::memory_order_release);
+      });
+    }
+
+    {
+      PROFILE_ZONE_UNDER("parallel_for", parent_zone);
+      fn(chunk_begin(count, chunk_count, 0), chunk_begin(count, chunk_count, 1), 0);
+    }
+    remaining.fetch_sub(1, std::memory_order_release);
+
+    wait(remaining);
+  }
+
+ private:
+  struct Queue {
+    std::mutex mutex{};
+    std::deque<Job> jobs{};
+  };
+
+  std::vector<Queue> queues;
+  std::vector<std::thread> threads{};
+  std::mutex sleep_mutex{};
+  std::condition_variable sleep_cv{};
+  std::atomic<int> queued_jobs{0};
+  bool stopping{false};
+
+  static int chunk_begin(int count, int chunk_count, int chunk) {
+    return static_cast<int>(static_cast<long>(count) * chunk / chunk_count);
+  }
+
+  void bind_current_thread(int queue_idx) const {
+    job_thread_binding = JobThreadBinding{this, queue_idx};
+  }
+
+  // Threads foreign to this system share the owner's queue.
+  int current_queue_index() const {
+    return job_thread_binding.owner == this ? job_thread_binding.queue_idx : 0;
+  }
+
+  bool pop(int queue_idx, bool from_back, Job &out) {
+    Queue &queue = queues[queue_idx];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty()) return false;
+
+    if (from_back) {
+      out = std::move(queue.jobs.back());
+      queue.jobs.pop_back();
+    } else {
+      out = std::move(queue.jobs.front());
+      queue.jobs.pop_front();
+    }
+    return true;
+  }
+
+  bool run_one(int queue_idx) {
+    Job job;
+    bool found = pop(queue_idx, true, job);
+
+    for (int i = 1; !found && i < size(); i++) found = pop((queue_idx + i) % size(), false, job);
+    if (!found) return false;
+
+    queued_jobs.fetch_sub(1, std::memory_order_relaxed);
+    job();
+    return true;
+  }
+
+  void worker_loop(int queue_idx) {
+    bind_current_thread(queue_idx);
+
+    while (true) {
+      if (run_one(queue_idx)) continue;
+
+      std::unique_lock<std::mutex> lock(sleep_mutex);
+      sleep_cv.wait(lock, [this] { return stopping || queued_jobs.load(std::memory_order_relaxed) > 0; });
+      if (stopping) return;
+    }
+  }
+};
+
+/**
+ * Tasks with dependencies, declared once and run as a whole as many times as needed. A task is submitted to the job
+ * system as soon as all of its dependencies are done, `run` returns when every task finished.
+ */
+struct TaskGraph {
+  struct Task {
+    const char *name;
+    std::function<void()> fn;
+    std::vector<int> successors{};
+    int dependency_count{0};
+    std::atomic<int> pending_dependencies{0};
+    // Summed over runs while `timed`.
+    double total_ms{0.0};
+  };
+
+  std::vector<std::unique_ptr<Task>> tasks{};
+  // Measure the wall time of every task, e.g. for benchmarks.
+  bool timed{false};
+
+  int add(const char *name, std::function<void()> fn, std::initializer_list<int> dependencies = {}) {
+    const int idx = static_cast<int>(tasks.size());
+
+    auto task = std::make_unique<Task>();
+    task->name = name;
+    task->fn = std::move(fn);
+    task->dependency_count = static_cast<int>(dependencies.size());
+    for (int dependency : dependencies) tasks[dependency]->successors.push_back(idx);
+
+    tasks.push_back(std::move(task));
+    return idx;
+  }
+
+  void reset_timings() {
+    for (auto &task : tasks) task->total_ms = 0.0;
+  }
+
+  void run(JobSystem &jobs) {
+#if PROFILER_ENABLED
+    profile_parent_zone = profile_current_zone;
+#endif
+    remaining_tasks.store(static_cast<int>(tasks.size()));
+    for (auto &task : tasks) task->pending_dependencies.store(task->dependency_count);
+
+    for (int i = 0; i < static_cast<int>(tasks.size()); i++) {
+      if (tasks[i]->dependency_count == 0) schedule(jobs, i);
+    }
+
+    jobs.wait(remaining_tasks);
+  }
+
+ private:
+  std::atomic<int> remaining_tasks{0};
+  // Zone open when `run` was called, the tasks' zones nest under it whichever thread runs them.
+  int profile_parent_zone{0};
+
+  void schedule(JobSystem &jobs, int idx) {
+    jobs.submit([this, &jobs, idx] {
+      Task &task = *tasks[idx];
+      {
+        PROFILE_ZONE_UNDER(task.name, profile_parent_zone);
+        if (timed) {
+          auto start = std::chrono::steady_clock::now();
+          task.fn();
+          task.total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        } else {
+          task.fn();
+        }
+      }
+
+      for (int successor : task.successors) {
+        if (tasks[successor]->pending_dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+          schedule(jobs, successor);
+        }
+      }
+
+      remaining_tasks.fetch_sub(1, std::memory_order_release);
+    });
+  }
+};
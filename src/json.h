@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "raylib.h"
+
+/**
+ * A parsed JSON document. Just enough to read back the reports this game writes (see `bench.h`).
+ */
+struct JsonValue {
+  enum class Type { Null, Bool, Number, String, Array, Object };
+
+  Type type{Type::Null};
+  bool boolean{false};
+  double number{0.0};
+  std::string string{};
+  std::vector<JsonValue> items{};
+  std::vector<std::pair<std::string, JsonValue>> members{};
+
+  // Member `key` of an object, or nullptr.
+  [[nodiscard]] JsonValue const *find(std::string const &key) const {
+    for (auto const &member : members) {
+      if (member.first == key) return &member.second;
+    }
+    return nullptr;
+  }
+
+  // Number member `key` of an object, or `fallback`.
+  [[nodiscard]] double number_or(std::string const &key, double fallback) const {
+    JsonValue const *value = find(key);
+    return value && value->type == Type::Number ? value->number : fallback;
+  }
+};
+
+struct JsonParser {
+  std::string const &text;
+  size_t pos{0};
+
+  explicit JsonParser(std::string const &_text) : text(_text) {
+  }
+
+  bool parse(JsonValue &out) {
+    if (!parse_value(out)) return false;
+    skip_whitespace();
+    return pos == text.size();
+  }
+
+ private:
+  void skip_whitespace() {
+    while (pos < text.size() && isspace(static_cast<unsigned char>(text[pos]))) pos++;
+  }
+
+  bool consume(char c) {
+    skip_whitespace();
+    if (pos >= text.size() || text[pos] != c) return false;
+    pos++;
+    return true;
+  }
+
+  bool consume_word(const char *word) {
+    const std::string expected{word};
+    if (text.compare(pos, expected.size(), expected) != 0) return false;
+    pos += expected.size();
+    return true;
+  }
+
+  bool parse_value(JsonValue &out) {
+    skip_whitespace();
+    if (pos >= text.size()) return false;
+
+    switch (text[pos]) {
+      case '{':
+        return parse_object(out);
+      case '[':
+        return parse_array(out);
+      case '"':
+        out.type = JsonValue::Type::String;
+        return parse_string(out.string);
+      case 't':
+        out.type = JsonValue::Type::Bool;
+        out.boolean = true;
+        return consume_word("true");
+      case 'f':
+        out.type = JsonValue::Type::Bool;
+        return consume_word("false");
+      case 'n':
+        return consume_word("null");
+      default:
+        return parse_number(out);
+    }
+  }
+
+  bool parse_object(JsonValue &out) {
+    out.type = JsonValue::Type::Object;
+    pos++;
+    if (consume('}')) return true;
+
+    do {
+      std::string key{};
+      skip_whitespace();
+      if (!parse_string(key) || !consume(':')) return false;
+
+      out.members.emplace_back(std::move(key), JsonValue{});
+      if (!parse_value(out.members.back().second)) return false;
+    } while (consume(','));
+    return consume('}');
+  }
+
+  bool parse_array(JsonValue &out) {
+    out.type = JsonValue::Type::Array;
+    pos++;
+    if (consume(']')) return true;
+
+    do {
+      out.items.emplace_back();
+      if (!parse_value(out.items.back())) return false;
+    } while (consume(','));
+    return consume(']');
+  }
+
+  // Escapes other than the single character ones are kept as written, the reports never contain them.
+  bool parse_string(std::string &out) {
+    if (pos >= text.size() || text[pos] != '"') return false;
+    pos++;
+
+    while (pos < text.size() && text[pos] != '"') {
+      if (text[pos] == '\\' && pos + 1 < text.size()) pos++;
+      out.push_back(text[pos++]);
+    }
+    if (pos >= text.size()) return false;
+    pos++;
+    return true;
+  }
+
+  // strtod also takes inf, nan and hex floats, which are no JSON numbers.
+  bool parse_number(JsonValue &out) {
+    if (text[pos] != '-' && !isdigit(static_cast<unsigned char>(text[pos]))) return false;
+    if (text.compare(pos, 2, "0x") == 0 || text.compare(pos, 3, "-0x") == 0) return false;
+
+    const char *start = text.c_str() + pos;
+    char *end{nullptr};
+    out.type = JsonValue::Type::Number;
+    out.number = strtod(start, &end);
+    if (end == start || !std::isfinite(out.number)) return false;
+    pos += end - start;
+    return true;
+  }
+};
+
+inline JsonValue read_json_file(std::string const &path) {
+  FILE *file = fopen(path.c_str(), "r");
+  if (!file) {
+    TraceLog(LOG_ERROR, "Cannot open JSON file: %s", path.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  std::string text{};
+  char buffer[4096];
+  size_t read_count;
+  while ((read_count = fread(buffer, 1, sizeof(buffer), file)) > 0) text.append(buffer, read_count);
+  fclose(file);
+
+  JsonValue root{};
+  JsonParser parser{text};
+  if (!parser.parse(root)) {
+    TraceLog(LOG_ERROR, "Invalid JSON in %s at offset %zu", path.c_str(), parser.pos);
+    exit(EXIT_FAILURE);
+  }
+  return root;
+}
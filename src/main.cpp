@@ -1,7 +1,16 @@
 #include "app.h"
 
-int main() {
-  App app = App();
+int main(int argc, char **argv) {
+  App app = App(parse_options(argc, argv));
   app.init();
-  app.run();
+
+  if (!app.options.bench_scenarios.empty()) {
+    if (!app.run_bench()) return EXIT_FAILURE;
+  } else if (app.options.stress) {
+    app.run_stress();
+  } else if (app.options.headless) {
+    app.run_headless();
+  } else {
+    app.run();
+  }
 }
@@ -3,6 +3,7 @@
 #include "asset_manager.h"
 #include "raylib.h"
 #include "raymath.h"
+#include "render_stats.h"
 
 constexpr float WORLD_PLAYER_MIDZONE_MARGIN_PERCENTAGE = 0.3f;
 constexpr int WORLD_RANDOM_SPOT_MAX_ATTEMPTS = 32;
@@ -10,59 +11,87 @@ constexpr float WORLD_OFFSET_MARGIN = 64.f;
 
 struct Map {
   Vector2 world_offset{};
+  // Size of the visible area. Follows the window, or stays at the initial window size in headless runs.
+  Vector2 view_size{};
+  // State of the previous simulation tick and the progress towards the next one, used to interpolate rendering.
+  Vector2 prev_world_offset{};
+  float interpolation_alpha{1.f};
 
   void init() {
     reset();
   }
 
   void reset() {
-    world_offset.x = -(asset_manager.images[ASSET_MAP_IMAGE].width - GetScreenWidth()) / 2.f;
-    world_offset.y = -(asset_manager.images[ASSET_MAP_IMAGE].height - GetScreenHeight()) / 2.f;
+    world_offset.x = -(asset_manager.images[ImageId::Map].width - view_size.x) / 2.f;
+    world_offset.y = -(asset_manager.images[ImageId::Map].height - view_size.y) / 2.f;
+    prev_world_offset = world_offset;
   }
 
   void update(Vector2 const& player_pos) {
+    prev_world_offset = world_offset;
     update_world_offset(player_pos);
   }
 
   void draw() const {
-    DrawTextureV(asset_manager.textures[ASSET_MAP_TEXTURE], world_offset, WHITE);
+    DrawTextureV(asset_manager.textures[TextureId::Map], draw_offset(), WHITE);
+    render_stats.quads(asset_manager.textures[TextureId::Map].id);
+  }
+
+  // World offset interpolated between the last two simulation ticks.
+  Vector2 draw_offset() const {
+    return Vector2Lerp(prev_world_offset, world_offset, interpolation_alpha);
+  }
+
+  Vector2 to_screen(Vector2 const& pos) const {
+    return Vector2Add(pos, draw_offset());
+  }
+
+  Vector2 to_screen(Vector2 const& prev_pos, Vector2 const& pos) const {
+    return Vector2Add(Vector2Lerp(prev_pos, pos, interpolation_alpha), draw_offset());
+  }
+
+  // Whether anything within `radius` of the world position can be on screen. Draw passes skip everything else.
+  bool is_visible(Vector2 const& pos, float radius) const {
+    Vector2 screen_pos = to_screen(pos);
+    return screen_pos.x + radius >= 0.f && screen_pos.y + radius >= 0.f && screen_pos.x - radius <= view_size.x &&
+           screen_pos.y - radius <= view_size.y;
   }
 
   void update_world_offset(Vector2 player_pos) {
     Vector2 player_rel_pos = Vector2Add(player_pos, world_offset);
 
-    float margin_left{GetScreenWidth() * WORLD_PLAYER_MIDZONE_MARGIN_PERCENTAGE};
+    float margin_left{view_size.x * WORLD_PLAYER_MIDZONE_MARGIN_PERCENTAGE};
     if (player_rel_pos.x < margin_left) world_offset.x += margin_left - player_rel_pos.x;
 
-    float margin_right{GetScreenWidth() * (1.0f - WORLD_PLAYER_MIDZONE_MARGIN_PERCENTAGE)};
+    float margin_right{view_size.x * (1.0f - WORLD_PLAYER_MIDZONE_MARGIN_PERCENTAGE)};
     if (player_rel_pos.x > margin_right) world_offset.x += margin_right - player_rel_pos.x;
 
-    float margin_top{GetScreenHeight() * WORLD_PLAYER_MIDZONE_MARGIN_PERCENTAGE};
+    float margin_top{view_size.y * WORLD_PLAYER_MIDZONE_MARGIN_PERCENTAGE};
     if (player_rel_pos.y < margin_top) world_offset.y += margin_top - player_rel_pos.y;
 
-    float margin_bottom{GetScreenHeight() * (1.0f - WORLD_PLAYER_MIDZONE_MARGIN_PERCENTAGE)};
+    float margin_bottom{view_size.y * (1.0f - WORLD_PLAYER_MIDZONE_MARGIN_PERCENTAGE)};
     if (player_rel_pos.y > margin_bottom) world_offset.y += margin_bottom - player_rel_pos.y;
 
     if (world_offset.x > WORLD_OFFSET_MARGIN) world_offset.x = WORLD_OFFSET_MARGIN;
     if (world_offset.y > WORLD_OFFSET_MARGIN) world_offset.y = WORLD_OFFSET_MARGIN;
-    if (world_offset.x < -width() + GetScreenWidth() - WORLD_OFFSET_MARGIN)
-      world_offset.x = -width() + GetScreenWidth() - WORLD_OFFSET_MARGIN;
-    if (world_offset.y < -height() + GetScreenHeight() - WORLD_OFFSET_MARGIN)
-      world_offset.y = -height() + GetScreenHeight() - WORLD_OFFSET_MARGIN;
+    if (world_offset.x < -width() + view_size.x - WORLD_OFFSET_MARGIN)
+      world_offset.x = -width() + view_size.x - WORLD_OFFSET_MARGIN;
+    if (world_offset.y < -height() + view_size.y - WORLD_OFFSET_MARGIN)
+      world_offset.y = -height() + view_size.y - WORLD_OFFSET_MARGIN;
   }
 
   bool is_hit(Vector2 point) const {
     if (point.x < 0.f || point.y < 0.f || point.x >= width() || point.y >= height()) return true;
 
     // TraceLog(LOG_INFO, "Col: %d", GetImageColor(map_image, point_abs_adjusted.x, point_abs_adjusted.y).r);
-    return GetImageColor(asset_manager.images[ASSET_MAP_IMAGE], point.x, point.y).r < 255;
+    return GetImageColor(asset_manager.images[ImageId::Map], point.x, point.y).r < 255;
   }
 
   int width() const {
-    return asset_manager.images[ASSET_MAP_IMAGE].width;
+    return asset_manager.images[ImageId::Map].width;
   }
 
   int height() const {
-    return asset_manager.images[ASSET_MAP_IMAGE].height;
+    return asset_manager.images[ImageId::Map].height;
   }
 };
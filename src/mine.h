@@ -15,8 +15,12 @@ struct Mine final : AttackDamage {
   }
 
   void draw(Map const &map) const {
-    DrawCircleV(Vector2Add(pos, map.world_offset), MINE_RADIUS, MAROON);
-    DrawCircleV(Vector2Add(pos, map.world_offset), MINE_RADIUS / 2.f, GOLD);
+    if (!map.is_visible(pos, MINE_RADIUS)) return;
+
+    DrawCircleV(map.to_screen(pos), MINE_RADIUS, MAROON);
+    DrawCircleV(map.to_screen(pos), MINE_RADIUS / 2.f, GOLD);
+    render_stats.circle();
+    render_stats.circle();
   }
 
   void kill() {
@@ -2,31 +2,124 @@
 
 #include <raylib.h>
 
+#include <algorithm>
 #include <list>
+#include <vector>
 
+#include "collectibles.h"
 #include "enemy.h"
 #include "map.h"
 #include "player.h"
+#include "render_stats.h"
 
 #define REL_POS(full, absolute) (absolute * MINIMAP_SIZE / full)
 
 constexpr int MINIMAP_SIZE = 100;
 constexpr int MINIMAP_PIXEL_SIZE = 2;
+constexpr int MINIMAP_MARGIN = 4;
+// Markers at the far edge of the map still fit.
+constexpr int MINIMAP_TEXTURE_SIZE = MINIMAP_SIZE + MINIMAP_PIXEL_SIZE;
+// Marker layer refreshes per second.
+constexpr int MINIMAP_REFRESH_RATE = 10;
 
+/**
+ * Minimap in two cached layers: the terrain, rendered once, and the entity markers, plotted into a pixel buffer and
+ * uploaded only `refresh_rate` times a second. Drawing a frame costs two textures and the player marker.
+ */
 struct Minimap {
-  void draw(Map const& map, Player const& player, std::list<Enemy> const& enemies) const {
-    const float w{static_cast<float>(map.width())};
-    const float h{static_cast<float>(map.height())};
+  float refresh_interval{1.f / MINIMAP_REFRESH_RATE};
 
-    DrawRectangle(4, 4, MINIMAP_SIZE + MINIMAP_PIXEL_SIZE - 1, MINIMAP_SIZE + MINIMAP_PIXEL_SIZE - 1,
-                  ColorAlpha(DARKGRAY, 0.8f));
+  ~Minimap() {
+    if (terrain.id == 0) return;
 
-    DrawRectangle(REL_POS(w, player.pos->x) + 4, REL_POS(h, player.pos->y) + 4, MINIMAP_PIXEL_SIZE, MINIMAP_PIXEL_SIZE,
-                  WHITE);
+    UnloadRenderTexture(terrain);
+    UnloadTexture(markers);
+  }
+
+  void init(Map const& map, int refresh_rate) {
+    refresh_interval = 1.f / std::max(1, refresh_rate);
+    map_size = Vector2{static_cast<float>(map.width()), static_cast<float>(map.height())};
+
+    terrain = LoadRenderTexture(MINIMAP_TEXTURE_SIZE, MINIMAP_TEXTURE_SIZE);
+    BeginTextureMode(terrain);
+    ClearBackground(ColorAlpha(DARKGRAY, 0.8f));
+    for (int y = 0; y < MINIMAP_SIZE; y++) {
+      for (int x = 0; x < MINIMAP_SIZE; x++) {
+        Vector2 world_pos{(x + 0.5f) * map_size.x / MINIMAP_SIZE, (y + 0.5f) * map_size.y / MINIMAP_SIZE};
+        if (map.is_hit(world_pos)) DrawPixel(x, y, ColorAlpha(BLACK, 0.6f));
+      }
+    }
+    EndTextureMode();
+
+    marker_pixels.assign(MINIMAP_TEXTURE_SIZE * MINIMAP_TEXTURE_SIZE, BLANK);
+    Image marker_image{marker_pixels.data(), MINIMAP_TEXTURE_SIZE, MINIMAP_TEXTURE_SIZE, 1,
+                       PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+    markers = LoadTextureFromImage(marker_image);
+  }
+
+  // Called every rendered frame, re-plots the markers when a refresh is due.
+  void update(float frame_time, std::list<Enemy> const& enemies, std::list<Collectible> const& collectibles,
+              std::list<EnemySpawner> const& enemy_spawners) {
+    since_refresh += frame_time;
+    if (since_refresh < refresh_interval) return;
+    since_refresh = 0.f;
+
+    std::fill(marker_pixels.begin(), marker_pixels.end(), BLANK);
+
+    for (auto const& enemy_spawner : enemy_spawners) {
+      if (!enemy_spawner.is_dead()) plot(enemy_spawner.pos, PURPLE, MINIMAP_PIXEL_SIZE + 1);
+    }
+
+    for (auto const& collectible : collectibles) {
+      switch (collectible.ty) {
+        case CollectibleType::Health:
+          plot(collectible.pos, LIME, MINIMAP_PIXEL_SIZE);
+          break;
+        case CollectibleType::Bullet:
+          plot(collectible.pos, GOLD, MINIMAP_PIXEL_SIZE);
+          break;
+        case CollectibleType::Mine:
+          plot(collectible.pos, ORANGE, MINIMAP_PIXEL_SIZE);
+          break;
+      }
+    }
 
     for (auto const& enemy : enemies) {
-      DrawRectangle(REL_POS(w, enemy.pos.x) + 4, REL_POS(h, enemy.pos.y) + 4, MINIMAP_PIXEL_SIZE, MINIMAP_PIXEL_SIZE,
-                    RED);
+      if (!enemy.is_dead) plot(enemy.pos, RED, MINIMAP_PIXEL_SIZE);
+    }
+
+    UpdateTexture(markers, marker_pixels.data());
+  }
+
+  void draw(Player const& player) const {
+    // Render textures are stored upside down.
+    DrawTextureRec(terrain.texture, Rectangle{0.f, 0.f, MINIMAP_TEXTURE_SIZE, -MINIMAP_TEXTURE_SIZE},
+                   Vector2{MINIMAP_MARGIN, MINIMAP_MARGIN}, WHITE);
+    DrawTexture(markers, MINIMAP_MARGIN, MINIMAP_MARGIN, WHITE);
+    render_stats.quads(terrain.texture.id);
+    render_stats.quads(markers.id);
+
+    // The player moves every frame, so it is not cached.
+    DrawRectangle(REL_POS(map_size.x, player.pos->x) + MINIMAP_MARGIN,
+                  REL_POS(map_size.y, player.pos->y) + MINIMAP_MARGIN, MINIMAP_PIXEL_SIZE, MINIMAP_PIXEL_SIZE, WHITE);
+    render_stats.shape_quads();
+  }
+
+ private:
+  RenderTexture2D terrain{};
+  Texture2D markers{};
+  std::vector<Color> marker_pixels{};
+  Vector2 map_size{};
+  float since_refresh{0.f};
+
+  void plot(Vector2 const& pos, Color color, int size) {
+    const int left = static_cast<int>(REL_POS(map_size.x, pos.x));
+    const int top = static_cast<int>(REL_POS(map_size.y, pos.y));
+
+    for (int y = std::max(0, top); y < std::min(MINIMAP_TEXTURE_SIZE, top + size); y++) {
+      for (int x = std::max(0, left); x < std::min(MINIMAP_TEXTURE_SIZE, left + size); x++) {
+        marker_pixels[y * MINIMAP_TEXTURE_SIZE + x] = color;
+      }
     }
   }
 };
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "common.h"
+#include "minimap.h"
+#include "raylib.h"
+#include "tuning.h"
+
+// Simulated time a headless match lasts at most, unless `--max-ticks` is given.
+constexpr int MATCH_MAX_SECONDS = 60 * 5;
+
+/**
+ * Command line options.
+ */
+struct Options {
+  bool headless{false};
+  // Seed of the random streams. Random unless given, runs with the same seed and input play out identically.
+  u_int64_t seed{static_cast<u_int64_t>(time(nullptr))};
+  int tick_rate{SIMULATION_TICK_RATE};
+  // Threads used for parallel update phases, including the main thread.
+  int threads{std::max(1, static_cast<int>(std::thread::hardware_concurrency()))};
+  // Headless only: number of matches to play and the tick limit of a single match.
+  int matches{1};
+  // 0 until parsed, then `MATCH_MAX_SECONDS` at the chosen tick rate unless given.
+  int max_ticks{0};
+  // Headless only: `autopilot`, `idle` or the path of an input script (see `ScriptedInput`).
+  std::string input{"autopilot"};
+  // Refreshes of the minimap markers per second.
+  int minimap_rate{MINIMAP_REFRESH_RATE};
+  // Profile builds: trace capture from the start, written here on exit. Empty for none.
+  std::string trace_file{};
+  // Frame times of every frame are written here. Empty for none.
+  std::string perf_csv{};
+  Tuning tuning{};
+  // Benchmark scenarios to run headless, instead of playing. See `BenchScenario`.
+  std::vector<std::string> bench_scenarios{};
+  std::string bench_report{"bench_report.json"};
+  // Runs of every scenario, the report holds their median.
+  int bench_runs{1};
+  // Report to compare against, failing on a slowdown. Empty for none. See `BenchGate`.
+  std::string bench_baseline{};
+  double bench_max_slowdown{BENCH_GATE_MAX_SLOWDOWN};
+  // Skip scenarios and metrics the baseline does not have, instead of failing on them.
+  bool bench_allow_missing{false};
+  // Ramp entity counts headless until the tick goes over budget, instead of playing. See `StressConfig`.
+  bool stress{false};
+  std::string stress_config{};
+  std::string stress_report{"stress_report.json"};
+};
+
+inline void print_usage(const char *bin) {
+  printf(
+      "Usage: %s [options]\n"
+      "  --headless         Run the simulation without window and audio, as fast as possible.\n"
+      "  --seed <n>         Seed of the random streams (default: current time).\n"
+      "  --tick-rate <n>    Simulation ticks per second (default: %d).\n"
+      "  --threads <n>      Threads for parallel update phases (default: hardware concurrency).\n"
+      "  --matches <n>      Headless: number of matches to play (default: 1).\n"
+      "  --max-ticks <n>    Headless: tick limit of a single match (default: %d s worth of ticks).\n"
+      "  --input <source>   Headless: autopilot, idle or path to an input script (default: autopilot).\n"
+      "  --minimap-rate <n> Minimap marker refreshes per second (default: %d).\n"
+      "  --trace <file>     Profile builds: capture a Chrome trace from the start, written on exit (F3 toggles).\n"
+      "  --perf-csv <file>  Write the CPU and full time of every frame to a CSV file.\n"
+      "  --spawners <n>     Number of enemy spawners (default: %d).\n"
+      "  --max-enemies <n>  Spawners wait while this many enemies are alive (default: 0, no limit).\n"
+      "  --tuning <file>    Read tuning knobs from a settings file (`<key> <value>` per line).\n"
+      "  --tune <key=value> Set a single tuning knob, e.g. spawn_interval=2.5.\n"
+      "  --bench <file>     Run a benchmark scenario headless, can be repeated. Implies --headless.\n"
+      "  --bench-report <f> JSON report of the benchmark scenarios (default: bench_report.json).\n"
+      "  --bench-runs <n>   Runs of every scenario, the median is reported (default: 1).\n"
+      "  --bench-baseline <f> Compare against this report, exit with failure on a slowdown.\n"
+      "  --bench-max-slowdown <pct> Slowdown tolerated over the baseline, beyond the noise (default: %.0f).\n"
+      "  --bench-allow-missing Skip scenarios and metrics the baseline does not have, instead of failing.\n"
+      "  --stress           Ramp enemies, bullets and particles until over the tick budget. Implies --headless.\n"
+      "  --stress-config <f> Settings file of the stress ramps. Implies --stress.\n"
+      "  --stress-report <f> JSON report of the stress ramps (default: stress_report.json).\n",
+      bin, SIMULATION_TICK_RATE, MATCH_MAX_SECONDS, MINIMAP_REFRESH_RATE, ENEMY_SPAWNER_COUNT,
+      BENCH_GATE_MAX_SLOWDOWN * 100.0);
+}
+
+inline Options parse_options(int argc, char **argv) {
+  Options options{};
+
+  for (int i = 1; i < argc; i++) {
+    auto has_value = [&]() {
+      if (i + 1 < argc) return true;
+
+      TraceLog(LOG_ERROR, "Missing value for %s", argv[i]);
+      exit(EXIT_FAILURE);
+    };
+
+    if (strcmp(argv[i], "--headless") == 0) {
+      options.headless = true;
+    } else if (strcmp(argv[i], "--seed") == 0 && has_value()) {
+      options.seed = strtoull(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--tick-rate") == 0 && has_value()) {
+      options.tick_rate = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--threads") == 0 && has_value()) {
+      options.threads = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--matches") == 0 && has_value()) {
+      options.matches = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--max-ticks") == 0 && has_value()) {
+      options.max_ticks = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--input") == 0 && has_value()) {
+      options.input = argv[++i];
+    } else if (strcmp(argv[i], "--minimap-rate") == 0 && has_value()) {
+      options.minimap_rate = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--trace") == 0 && has_value()) {
+      options.trace_file = argv[++i];
+    } else if (strcmp(argv[i], "--perf-csv") == 0 && has_value()) {
+      options.perf_csv = argv[++i];
+    } else if (strcmp(argv[i], "--spawners") == 0 && has_value()) {
+      options.tuning.enemy_spawner_count = std::max(0, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--max-enemies") == 0 && has_value()) {
+      options.tuning.max_enemies = std::max(0, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--tuning") == 0 && has_value()) {
+      const char *path = argv[++i];
+      read_settings_file(path, [&](const char *key, const char *value) { return options.tuning.set(key, value); });
+    } else if (strcmp(argv[i], "--tune") == 0 && has_value()) {
+      std::string setting{argv[++i]};
+      const size_t separator = setting.find('=');
+      if (separator == std::string::npos ||
+          !options.tuning.set(setting.substr(0, separator).c_str(), setting.substr(separator + 1).c_str())) {
+        TraceLog(LOG_ERROR, "Invalid tuning setting: %s", setting.c_str());
+        exit(EXIT_FAILURE);
+      }
+    } else if (strcmp(argv[i], "--bench") == 0 && has_value()) {
+      options.bench_scenarios.emplace_back(argv[++i]);
+      options.headless = true;
+    } else if (strcmp(argv[i], "--bench-report") == 0 && has_value()) {
+      options.bench_report = argv[++i];
+    } else if (strcmp(argv[i], "--bench-runs") == 0 && has_value()) {
+      options.bench_runs = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--bench-baseline") == 0 && has_value()) {
+      options.bench_baseline = argv[++i];
+    } else if (strcmp(argv[i], "--bench-max-slowdown") == 0 && has_value()) {
+      options.bench_max_slowdown = std::max(0.0, atof(argv[++i]) / 100.0);
+    } else if (strcmp(argv[i], "--bench-allow-missing") == 0) {
+      options.bench_allow_missing = true;
+    } else if (strcmp(argv[i], "--stress") == 0) {
+      options.stress = true;
+      options.headless = true;
+    } else if (strcmp(argv[i], "--stress-config") == 0 && has_value()) {
+      options.stress_config = argv[++i];
+      options.stress = true;
+      options.headless = true;
+    } else if (strcmp(argv[i], "--stress-report") == 0 && has_value()) {
+      options.stress_report = argv[++i];
+    } else if (strcmp(argv[i], "--help") == 0) {
+      print_usage(argv[0]);
+      exit(EXIT_SUCCESS);
+    } else {
+      TraceLog(LOG_ERROR, "Unknown option: %s", argv[i]);
+      print_usage(argv[0]);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (options.tick_rate <= 0) {
+    TraceLog(LOG_ERROR, "Invalid tick rate: %d", options.tick_rate);
+    exit(EXIT_FAILURE);
+  }
+  if (options.max_ticks <= 0) options.max_ticks = options.tick_rate * MATCH_MAX_SECONDS;
+
+  return options;
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "raylib.h"
+
+constexpr char PAK_MAGIC[4] = {'M', 'P', 'A', 'K'};
+constexpr u_int32_t PAK_VERSION = 1;
+constexpr int PAK_PATH_SIZE = 64;
+// Payloads start at multiples of this, so pixel and sample data is aligned for upload.
+constexpr u_int64_t PAK_ALIGNMENT = 16;
+
+constexpr u_int32_t PAK_ENTRY_IMAGE = 1;  // Decoded pixels. Params: width, height, pixel format, mipmaps.
+constexpr u_int32_t PAK_ENTRY_WAVE = 2;   // PCM samples. Params: frame count, sample rate, sample size, channels.
+constexpr u_int32_t PAK_ENTRY_RAW = 3;    // File as is, e.g. streamed music.
+// Largest image side read from an archive, keeps the pixel data size of any format within an int.
+constexpr u_int32_t PAK_MAX_IMAGE_SIZE = 8192;
+constexpr u_int32_t PAK_MAX_CHANNELS = 8;
+
+/**
+ * Asset archive layout: a `PakHeader`, `entry_count` `PakEntry` records, then the payloads. Native byte order - the
+ * archive is built on the machine it is used on.
+ */
+struct PakHeader {
+  char magic[4];
+  u_int32_t version;
+  u_int32_t entry_count;
+  u_int32_t reserved;
+};
+
+struct PakEntry {
+  // Relative to the application directory, e.g. `assets/images/player.png`.
+  char path[PAK_PATH_SIZE];
+  u_int32_t kind;
+  u_int32_t params[4];
+  u_int32_t reserved;
+  u_int64_t offset;
+  u_int64_t size;
+};
+
+static_assert(sizeof(PakHeader) == 16);
+static_assert(sizeof(PakEntry) == 104);
+
+/**
+ * Read-only, memory mapped asset archive. Images and waves handed out point straight into the mapping: they must not
+ * be unloaded, and stay valid until the archive is closed.
+ */
+struct PakArchive {
+  PakArchive() = default;
+  PakArchive(PakArchive const &) = delete;
+  PakArchive &operator=(PakArchive const &) = delete;
+
+  ~PakArchive() {
+    close();
+  }
+
+  bool open(const char *path) {
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size < static_cast<off_t>(sizeof(PakHeader))) {
+      ::close(fd);
+      TraceLog(LOG_WARNING, "Invalid asset archive: %s", path);
+      return false;
+    }
+
+    void *mapping = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+      TraceLog(LOG_WARNING, "Cannot map asset archive: %s", path);
+      return false;
+    }
+
+    data = static_cast<unsigned char const *>(mapping);
+    size = static_cast<size_t>(file_stat.st_size);
+
+    if (!build_index()) {
+      TraceLog(LOG_WARNING, "Invalid asset archive: %s", path);
+      close();
+      return false;
+    }
+
+    return true;
+  }
+
+  void close() {
+    if (data) munmap(const_cast<unsigned char *>(data), size);
+    data = nullptr;
+    size = 0;
+    index.clear();
+  }
+
+  [[nodiscard]] bool is_open() const {
+    return data != nullptr;
+  }
+
+  [[nodiscard]] int entry_count() const {
+    return static_cast<int>(index.size());
+  }
+
+  [[nodiscard]] PakEntry const *find(const char *path, u_int32_t kind) const {
+    auto it = index.find(path);
+    if (it == index.end() || it->second->kind != kind) return nullptr;
+    return it->second;
+  }
+
+  [[nodiscard]] unsigned char const *payload(PakEntry const &entry) const {
+    return data + entry.offset;
+  }
+
+  // Whether memory belongs to the archive (and must not be freed).
+  [[nodiscard]] bool contains(void const *ptr) const {
+    auto const *byte = static_cast<unsigned char const *>(ptr);
+    return data && byte >= data && byte < data + size;
+  }
+
+  // raylib takes non-const pixel pointers, but only reads them for uploads and pixel queries.
+  [[nodiscard]] Image image(PakEntry const &entry) const {
+    return Image{const_cast<unsigned char *>(payload(entry)), static_cast<int>(entry.params[0]),
+                 static_cast<int>(entry.params[1]), static_cast<int>(entry.params[3]),
+                 static_cast<int>(entry.params[2])};
+  }
+
+  [[nodiscard]] Wave wave(PakEntry const &entry) const {
+    return Wave{entry.params[0], entry.params[1], entry.params[2], entry.params[3],
+                const_cast<unsigned char *>(payload(entry))};
+  }
+
+ private:
+  unsigned char const *data{nullptr};
+  size_t size{0};
+  std::unordered_map<std::string, PakEntry const *> index{};
+
+  bool build_index() {
+    auto const *header = reinterpret_cast<PakHeader const *>(data);
+    if (memcmp(header->magic, PAK_MAGIC, sizeof(PAK_MAGIC)) != 0 || header->version != PAK_VERSION) return false;
+    if (sizeof(PakHeader) + static_cast<size_t>(header->entry_count) * sizeof(PakEntry) > size) return false;
+
+    auto const *entries = reinterpret_cast<PakEntry const *>(data + sizeof(PakHeader));
+    for (u_int32_t i = 0; i < header->entry_count; i++) {
+      PakEntry const &entry = entries[i];
+      if (entry.path[PAK_PATH_SIZE - 1] != '\0' || entry.offset > size || entry.size > size - entry.offset ||
+          !params_fit(entry)) {
+        return false;
+      }
+      index[entry.path] = &entry;
+    }
+    return true;
+  }
+
+  // Whether the payload holds all the data its params describe, so images and waves never reach past it.
+  static bool params_fit(PakEntry const &entry) {
+    if (entry.kind == PAK_ENTRY_IMAGE) {
+      const u_int32_t width = entry.params[0];
+      const u_int32_t height = entry.params[1];
+      // The packer writes the base level only.
+      if (width == 0 || height == 0 || width > PAK_MAX_IMAGE_SIZE || height > PAK_MAX_IMAGE_SIZE ||
+          entry.params[3] != 1) {
+        return false;
+      }
+      const int pixel_size =
+          GetPixelDataSize(static_cast<int>(width), static_cast<int>(height), static_cast<int>(entry.params[2]));
+      return pixel_size > 0 && static_cast<u_int64_t>(pixel_size) <= entry.size;
+    }
+
+    if (entry.kind == PAK_ENTRY_WAVE) {
+      const u_int32_t sample_size = entry.params[2];
+      const u_int32_t channels = entry.params[3];
+      if ((sample_size != 8 && sample_size != 16 && sample_size != 32) || channels == 0 ||
+          channels > PAK_MAX_CHANNELS) {
+        return false;
+      }
+      return static_cast<u_int64_t>(entry.params[0]) * channels * sample_size / 8 <= entry.size;
+    }
+
+    return true;
+  }
+};
+
+/**
+ * Builds an asset archive, see `src/tools/packer.cpp`.
+ */
+struct PakWriter {
+  void add(std::string const &path, u_int32_t kind, std::array<u_int32_t, 4> params, void const *payload,
+           size_t payload_size) {
+    if (path.size() >= PAK_PATH_SIZE) {
+      TraceLog(LOG_ERROR, "Asset path too long for the archive: %s", path.c_str());
+      exit(EXIT_FAILURE);
+    }
+
+    PakEntry entry{};
+    strncpy(entry.path, path.c_str(), PAK_PATH_SIZE - 1);
+    entry.kind = kind;
+    for (int i = 0; i < 4; i++) entry.params[i] = params[i];
+    entry.size = payload_size;
+    entries.push_back(entry);
+
+    auto const *bytes = static_cast<unsigned char const *>(payload);
+    payloads.emplace_back(bytes, bytes + payload_size);
+  }
+
+  [[nodiscard]] int size() const {
+    return static_cast<int>(entries.size());
+  }
+
+  bool write(const char *path) {
+    u_int64_t offset = aligned(sizeof(PakHeader) + entries.size() * sizeof(PakEntry));
+    for (auto &entry : entries) {
+      entry.offset = offset;
+      offset = aligned(offset + entry.size);
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+
+    PakHeader header{};
+    memcpy(header.magic, PAK_MAGIC, sizeof(PAK_MAGIC));
+    header.version = PAK_VERSION;
+    header.entry_count = static_cast<u_int32_t>(entries.size());
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (!entries.empty()) ok &= fwrite(entries.data(), sizeof(PakEntry), entries.size(), file) == entries.size();
+    for (unsigned int i = 0; i < entries.size(); i++) {
+      ok &= fseek(file, static_cast<long>(entries[i].offset), SEEK_SET) == 0;
+      if (!payloads[i].empty()) ok &= fwrite(payloads[i].data(), 1, payloads[i].size(), file) == payloads[i].size();
+    }
+
+    return fclose(file) == 0 && ok;
+  }
+
+ private:
+  std::vector<PakEntry> entries{};
+  std::vector<std::vector<unsigned char>> payloads{};
+
+  static u_int64_t aligned(u_int64_t offset) {
+    return (offset + PAK_ALIGNMENT - 1) / PAK_ALIGNMENT * PAK_ALIGNMENT;
+  }
+};
@@ -3,8 +3,10 @@
 #include <cstdlib>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "common.h"
 #include "enemy.h"
@@ -12,112 +14,142 @@
 #include "raylib.h"
 
 constexpr float PARTICLE_SMOKE_SPEED = 80.f;
+// Largest extent of a particle around its position (grown smoke, trace marks).
+constexpr float PARTICLE_CULL_RADIUS = 32.f;
 
 struct Particle : UIElementAndDeletable {
   Vector2 pos{};
+  // Position of the previous tick, drawn interpolated towards `pos` like the camera. Kept by `ParticleManager`.
+  Vector2 prev_pos{};
+  // Armed on spawn, the timer wheel flags the particle for deletion when it runs out.
+  TimedTask lifetime;
 
-  Particle() = default;
-  explicit Particle(Vector2 _pos) : pos(_pos) {
+  Particle(Vector2 _pos, double _lifetime_seconds) : pos(_pos), lifetime(_lifetime_seconds) {
   }
 };
 
 struct ParticleManager {
-  std::list<std::unique_ptr<UIElementAndDeletable>> particles{};
+  std::shared_ptr<TimerWheel> timer_wheel;
+  std::list<std::unique_ptr<Particle>> particles{};
+
+  explicit ParticleManager(std::shared_ptr<TimerWheel> _timer_wheel) : timer_wheel(std::move(_timer_wheel)) {
+  }
 
-  void update() {
-    for (auto &particle : particles) particle->update();
+  // Particles spawned while the particle update may be running. They join `particles` in `flush_spawned`.
+  void spawn(std::unique_ptr<Particle> particle) {
+    particle->lifetime.start(*timer_wheel, &particle->should_be_deleted);
+    particle->prev_pos = particle->pos;
+
+    std::lock_guard<std::mutex> lock(spawned_mutex);
+    spawned.push_back(std::move(particle));
+  }
+
+  void flush_spawned() {
+    std::lock_guard<std::mutex> lock(spawned_mutex);
+    for (auto &particle : spawned) particles.push_back(std::move(particle));
+    spawned.clear();
+  }
+
+  void update(FrameClock const &clock) {
+    for (auto &particle : particles) {
+      particle->prev_pos = particle->pos;
+      particle->update(clock);
+    }
     std::erase_if(particles, [](auto const &e) { return e->should_be_deleted; });
   }
 
   void draw(Map const &map) const {
-    for (auto const &particle : particles) particle->draw(map);
+    for (auto const &particle : particles) {
+      if (map.is_visible(particle->pos, PARTICLE_CULL_RADIUS)) particle->draw(map);
+    }
   }
 
   void reset() {
     particles.clear();
+
+    std::lock_guard<std::mutex> lock(spawned_mutex);
+    spawned.clear();
   }
+
+ private:
+  std::vector<std::unique_ptr<Particle>> spawned{};
+  std::mutex spawned_mutex{};
 };
 
 struct SmokeParticle final : Particle {
-  TimedTask lifetime;
   float radius{2.0f};
   float phase_jitter;
   float alpha{0.2f};
 
-  explicit SmokeParticle(Vector2 const _pos) : Particle(_pos), lifetime(1.6) {
-    phase_jitter = static_cast<float>(rand() % 628) / 100.f;
+  explicit SmokeParticle(Vector2 const _pos) : Particle(_pos, 1.6) {
+    phase_jitter = static_cast<float>(cosmetic_rng.range(628)) / 100.f;
   }
   explicit SmokeParticle(Vector2 const _pos, const float pos_jitter)
-      : Particle(randomize_pos(_pos, pos_jitter)), lifetime(1.6) {
-    phase_jitter = static_cast<float>(rand() % 628) / 100.f;
+      : Particle(randomize_pos(cosmetic_rng, _pos, pos_jitter), 1.6) {
+    phase_jitter = static_cast<float>(cosmetic_rng.range(628)) / 100.f;
   }
   ~SmokeParticle() override = default;
 
   void draw(Map const &map) const override {
-    DrawCircleV(Vector2Add(pos, map.world_offset), radius, ColorAlpha(DARKGRAY, alpha));
+    DrawCircleV(map.to_screen(prev_pos, pos), radius, ColorAlpha(DARKGRAY, alpha));
+    render_stats.circle();
   };
-  void update() override {
-    pos.y -= PARTICLE_SMOKE_SPEED * GetFrameTime();
-    pos.x += sinf(GetTime() * 10.f + phase_jitter) * 0.3f;
-    radius += GetFrameTime() * 10.f;
-    alpha -= GetFrameTime() * 0.1f;
-
-    if (lifetime.is_completed()) should_be_deleted = true;
+  void update(FrameClock const &clock) override {
+    pos.y -= PARTICLE_SMOKE_SPEED * clock.dt;
+    pos.x += sinf(clock.now * 10.f + phase_jitter) * 0.3f;
+    radius += clock.dt * 10.f;
+    alpha -= clock.dt * 0.1f;
   };
 };
 
 struct ExplosionParticle final : Particle {
   Vector2 v{};
-  TimedTask lifetime;
   float size_jitter;
   Color color;
 
   ExplosionParticle(Vector2 _pos, Vector2 _v, Color _color = GOLD)
-      : Particle(_pos), v(_v), lifetime(1.5), color(_color) {
-    size_jitter = static_cast<float>(rand() % 100) / 200.f + 0.75f;
+      : Particle(_pos, 1.5), v(_v), color(_color) {
+    size_jitter = static_cast<float>(cosmetic_rng.range(100)) / 200.f + 0.75f;
   }
 
   void draw(Map const &map) const override {
-    DrawCircleV(Vector2Add(pos, map.world_offset), 6.f * size_jitter, color);
+    DrawCircleV(map.to_screen(prev_pos, pos), 6.f * size_jitter, color);
+    render_stats.circle();
   };
 
-  void update() override {
-    pos.x += v.x;
-    pos.y += v.y;
+  void update(FrameClock const &clock) override {
+    pos.x += v.x * clock.dt;
+    pos.y += v.y * clock.dt;
 
-    fps_independent_multiply(&v.x, 0.99f);
-    fps_independent_multiply(&v.y, 0.99f);
-
-    if (lifetime.is_completed()) should_be_deleted = true;
+    fps_independent_multiply(&v.x, 0.99f, clock.dt);
+    fps_independent_multiply(&v.y, 0.99f, clock.dt);
   }
 };
 
 struct StraightLineParticle final : Particle {
   float angle_rad{};
   float speed{};
-  TimedTask lifetime;
   float size{6.f};
   float speed_multiplier{1.0};
   Color color{GOLD};
   float pos_jitter{40.f};
 
   StraightLineParticle(Vector2 _pos, float _angle_rad, float _speed, double _lifetime)
-      : Particle(_pos), angle_rad(_angle_rad), speed(_speed), lifetime(_lifetime) {
-    pos.x += randf() * pos_jitter - pos_jitter / 2.f;
-    pos.y += randf() * pos_jitter - pos_jitter / 2.f;
+      : Particle(_pos, _lifetime), angle_rad(_angle_rad), speed(_speed) {
+    pos.x += randf(cosmetic_rng) * pos_jitter - pos_jitter / 2.f;
+    pos.y += randf(cosmetic_rng) * pos_jitter - pos_jitter / 2.f;
   }
 
   void draw(Map const &map) const override {
-    DrawCircleV(Vector2Add(pos, map.world_offset), size, color);
+    DrawCircleV(map.to_screen(prev_pos, pos), size, color);
+    render_stats.circle();
   };
 
-  void update() override {
-    pos.x += cosf(angle_rad) * speed * GetFrameTime();
-    pos.y += sinf(angle_rad) * speed * GetFrameTime();
+  void update(FrameClock const &clock) override {
+    pos.x += cosf(angle_rad) * speed * clock.dt;
+    pos.y += sinf(angle_rad) * speed * clock.dt;
 
-    if (speed_multiplier < 1.0f) fps_independent_multiply(&speed, speed_multiplier);
-
-    if (lifetime.is_completed()) should_be_deleted = true;
+    if (speed_multiplier < 1.0f) fps_independent_multiply(&speed, speed_multiplier, clock.dt);
   }
 };
 
@@ -125,32 +157,31 @@ struct TraceParticle final : Particle {
   float angle_deg;
   float alpha{0.3};
 
-  TimedTask lifetime{1.0};
-
-  TraceParticle(Vector2 _pos, float _angle_deg) : Particle(_pos), angle_deg(_angle_deg) {
+  TraceParticle(Vector2 _pos, float _angle_deg) : Particle(_pos, 1.0), angle_deg(_angle_deg) {
   }
 
   void draw(Map const &map) const override {
-    DrawRectanglePro(Rectangle{pos.x + map.world_offset.x, pos.y + map.world_offset.y, 10.f, 10.f},
-                     Vector2{20.f, -20.f}, angle_deg, ColorAlpha(DARKBROWN, alpha));
+    Vector2 screen_pos = map.to_screen(prev_pos, pos);
+    DrawRectanglePro(Rectangle{screen_pos.x, screen_pos.y, 10.f, 10.f}, Vector2{20.f, -20.f}, angle_deg,
+                     ColorAlpha(DARKBROWN, alpha));
 
-    DrawRectanglePro(Rectangle{pos.x + map.world_offset.x, pos.y + map.world_offset.y, 10.f, 10.f},
-                     Vector2{-10.f, -20.f}, angle_deg, ColorAlpha(DARKBROWN, alpha));
+    DrawRectanglePro(Rectangle{screen_pos.x, screen_pos.y, 10.f, 10.f}, Vector2{-10.f, -20.f}, angle_deg,
+                     ColorAlpha(DARKBROWN, alpha));
+    render_stats.shape_quads(2);
   }
 
-  void update() override {
-    if (lifetime.is_completed()) should_be_deleted = true;
-    alpha -= GetFrameTime() * 0.4f;
+  void update(FrameClock const &clock) override {
+    alpha -= clock.dt * 0.4f;
   }
 };
 
 void make_explosion(ParticleManager &particle_manager, Vector2 const &pos, const float speed, const int count,
                     const Color &color) {
   for (int i = 0; i < count; i++) {
-    float particle_angle = rand() % 360 * DEG2RAD;
-    float particle_speed_jitter = static_cast<float>(rand() % 100) / 200.f + 0.75f;
-    Vector2 v{cosf(particle_angle) * speed * GetFrameTime() * particle_speed_jitter,
-              sinf(particle_angle) * speed * GetFrameTime() * particle_speed_jitter};
-    particle_manager.particles.push_back(std::make_unique<ExplosionParticle>(pos, v, color));
+    float particle_angle = cosmetic_rng.range(360) * DEG2RAD;
+    float particle_speed_jitter = static_cast<float>(cosmetic_rng.range(100)) / 200.f + 0.75f;
+    Vector2 v{cosf(particle_angle) * speed * particle_speed_jitter,
+              sinf(particle_angle) * speed * particle_speed_jitter};
+    particle_manager.spawn(std::make_unique<ExplosionParticle>(pos, v, color));
   }
 }
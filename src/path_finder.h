@@ -1,13 +1,16 @@
 #pragma once
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <queue>
 #include <ranges>
 #include <vector>
 
+#include "ai_stats.h"
 #include "common.h"
 #include "map.h"
+#include "profiler.h"
 #include "raylib.h"
 
 #define PF_CELL_IDX(x, y) (y * cells_w + x)
@@ -45,12 +48,25 @@ struct PathFinder {
   }
 
   [[nodiscard]] std::vector<IntVector2> find_path(Vector2 start, Vector2 end) const {
+    PROFILE_ZONE("find_path");
     IntVector2 start_normalized = closest_available_cell_idx_from_coord(start);
     IntVector2 end_normalized = closest_available_cell_idx_from_coord(end);
     return find_path(start_normalized, end_normalized);
   }
 
+  // Counted in `ai_stats`: the call, nodes expanded, open list peak, time and whether a path was found.
   [[nodiscard]] std::vector<IntVector2> find_path(IntVector2 start, IntVector2 end) const {
+    auto query_start = std::chrono::steady_clock::now();
+    u_int64_t nodes_expanded{0};
+    int heap_peak{0};
+    std::vector<IntVector2> path = search_path(start, end, nodes_expanded, heap_peak);
+    std::chrono::nanoseconds query_time = std::chrono::steady_clock::now() - query_start;
+    ai_stats.record_path(nodes_expanded, heap_peak, query_time.count(), !path.empty());
+    return path;
+  }
+
+  [[nodiscard]] std::vector<IntVector2> search_path(IntVector2 start, IntVector2 end, u_int64_t &nodes_expanded,
+                                                    int &heap_peak) const {
     if (is_out_of_bounds(start)) {
       TraceLog(LOG_ERROR, "[PF] start is out of bound: %d:%d.", start.x, start.y);
       return {};
@@ -98,6 +114,7 @@ struct PathFinder {
       std::ranges::pop_heap(queue, std::greater{});
       PFCell min_cell = queue.back();
       queue.pop_back();
+      nodes_expanded++;
 
       TraceLog(LOG_DEBUG, "Min cell: %d:%d G=%.2f H=%.2f F=%.2f", min_cell.p.x, min_cell.p.y, min_cell.prefix,
                min_cell.suffix, min_cell.total());
@@ -122,6 +139,7 @@ struct PathFinder {
         queue.emplace_back(heuristic_distance(min_cell.p, neighbor_coord), heuristic_distance(neighbor_coord, end),
                            neighbor_coord);
         std::ranges::push_heap(queue, std::greater{});
+        heap_peak = std::max(heap_peak, static_cast<int>(queue.size()));
 
         TraceLog(LOG_DEBUG, "- pushed: %d:%d", neighbor_coord.x, neighbor_coord.y);
 
@@ -164,7 +182,7 @@ struct PathFinder {
     IntVector2 pos;
 
     for (int i = 0; i < PF_RANDOM_SPOT_MAX_ATTEMPTS; i++) {
-      pos = IntVector2{rand() % cells_w, rand() % cells_h};
+      pos = IntVector2{gameplay_rng.range(cells_w), gameplay_rng.range(cells_h)};
 
       if (is_discoverable(pos)) return pos;
     }
@@ -210,8 +228,8 @@ struct PathFinder {
   }
 
   bool init_available_cells(Map const &map) {
-    cells_w = asset_manager.images[ASSET_MAP_IMAGE].width / CELL_DISTANCE + 1;
-    cells_h = asset_manager.images[ASSET_MAP_IMAGE].height / CELL_DISTANCE + 1;
+    cells_w = asset_manager.images[ImageId::Map].width / CELL_DISTANCE + 1;
+    cells_h = asset_manager.images[ImageId::Map].height / CELL_DISTANCE + 1;
 
     if (cells_w * cells_w >= MAX_GRID_CELLS) {
       TraceLog(LOG_ERROR, "Map too large");
@@ -5,9 +5,11 @@
 #include <memory>
 
 #include "asset_manager.h"
+#include "audio.h"
 #include "bullet.h"
 #include "collectibles.h"
 #include "common.h"
+#include "input.h"
 #include "map.h"
 #include "mine.h"
 #include "particles.h"
@@ -26,7 +28,10 @@ constexpr int PLAYER_HEALTH_COLLECT = 25;
 constexpr int PLAYER_BULLET_COLLECT = 50;
 
 struct Player {
+  // First, so the timers below are cancelled while the wheel is still alive.
+  std::shared_ptr<TimerWheel> timer_wheel;
   std::shared_ptr<Vector2> pos = std::make_shared<Vector2>();
+  Vector2 prev_pos{};
   float circle_frame_radius{};
   float angle{};         // Degree.
   float target_angle{};  // Degree.
@@ -38,16 +43,25 @@ struct Player {
   int kill_count{};
   int mine_count{};
   std::shared_ptr<ParticleManager> particle_manager;
-  RepeatedTask smoke_particle_scheduler{0.08};
-  RepeatedTask wheel_trace_particle_scheduler{0.05};
-  RepeatedTask rapid_fire_scheduler{0.05};
-  TimedRepeatedTask hurt_particle_timed_repeater{0.02};
-
-  Player(std::shared_ptr<ParticleManager> _particle_manager) : particle_manager(std::move(_particle_manager)) {
+  std::shared_ptr<Audio> audio;
+  RepeatedTask smoke_particle_scheduler;
+  RepeatedTask wheel_trace_particle_scheduler;
+  RepeatedTask rapid_fire_scheduler;
+  TimedRepeatedTask hurt_particle_timed_repeater;
+
+  Player(std::shared_ptr<ParticleManager> _particle_manager, std::shared_ptr<Audio> _audio,
+         std::shared_ptr<TimerWheel> _timer_wheel)
+      : timer_wheel(std::move(_timer_wheel)),
+        particle_manager(std::move(_particle_manager)),
+        audio(std::move(_audio)),
+        smoke_particle_scheduler(*timer_wheel, 0.08),
+        wheel_trace_particle_scheduler(*timer_wheel, 0.05),
+        rapid_fire_scheduler(*timer_wheel, 0.05),
+        hurt_particle_timed_repeater(*timer_wheel, 0.02) {
   }
 
   void init() {
-    circle_frame_radius = asset_manager.textures[ASSET_PLAYER_TEXTURE].width / 2.f;
+    circle_frame_radius = asset_manager.sprites[SpriteId::Player].source.width / 2.f;
   }
 
   void reset(PathFinder const &path_finder) {
@@ -57,28 +71,33 @@ struct Player {
     bullets.clear();
     pos->x = path_finder.start_pos.x * CELL_DISTANCE;
     pos->y = path_finder.start_pos.y * CELL_DISTANCE;
+    prev_pos = *pos;
     bullet_count = PLAYER_STARTER_BULLET_COUNT;
     mine_count = PLAYER_STARTER_MINE_COUNT;
     health = PLAYER_MAX_HEALTH;
     kill_count = 0;
     particle_manager->reset();
     mines.clear();
+    smoke_particle_scheduler.restart();
+    wheel_trace_particle_scheduler.restart();
+    rapid_fire_scheduler.restart();
+    hurt_particle_timed_repeater.restart();
   }
 
-  void update(Map const &map) {
+  void update(FrameClock const &clock, Map const &map, InputState const &input) {
+    prev_pos = *pos;
+
     if (!is_dead()) {
-      update_movement(map);
-      update_rotation();
-      update_shooting();
-      update_mines();
+      update_movement(clock, map, input);
+      update_rotation(clock, input);
+      update_shooting(input);
+      update_mines(input);
       update_hurt_particles();
     }
 
     std::erase_if(bullets, [](auto e) { return e.should_be_deleted; });
     std::erase_if(mines, [](auto e) { return e.should_be_deleted; });
-    for (auto &bullet : bullets) bullet.update(map);
-
-    particle_manager->update();
+    for (auto &bullet : bullets) bullet.update(map, clock);
 
     if (health >= PLAYER_MAX_HEALTH * 0.95) {
       smoke_particle_scheduler.pause();
@@ -90,9 +109,7 @@ struct Player {
       smoke_particle_scheduler.set_interval(0.02);
     }
 
-    smoke_particle_scheduler.update();
-
-    if (smoke_particle_scheduler.did_tick) particle_manager->particles.push_back(std::make_unique<SmokeParticle>(*pos));
+    if (smoke_particle_scheduler.did_tick()) particle_manager->spawn(std::make_unique<SmokeParticle>(*pos));
   }
 
   void draw(Map const &map) const {
@@ -104,75 +121,43 @@ struct Player {
 
     // Draw main player.
     if (!is_dead()) {
-      draw_texture(asset_manager.textures[ASSET_PLAYER_TEXTURE], screen_relative_center(map.world_offset),
-                   target_angle);
+      draw_sprite(asset_manager.sprites[SpriteId::Player], map.to_screen(prev_pos, *pos), target_angle);
     } else {
-      draw_texture(asset_manager.textures[ASSET_PLAYER_BROKEN_TEXTURE], screen_relative_center(map.world_offset),
-                   target_angle);
+      draw_sprite(asset_manager.sprites[SpriteId::PlayerBroken], map.to_screen(prev_pos, *pos), target_angle);
     }
-
-    // Draw HUD.
-    DrawRectangle(GetScreenWidth() - 144, GetScreenHeight() - 104, 140, 100, ColorAlpha(DARKGRAY, 0.9f));
-
-    // Health bar.
-    DrawRectangle(GetScreenWidth() - 112, GetScreenHeight() - 96, (health / PLAYER_MAX_HEALTH) * 100.f, 12, RED);
-    DrawRectangleLinesEx(
-        Rectangle{static_cast<float>(GetScreenWidth() - 116), static_cast<float>(GetScreenHeight() - 100), 108.f, 20.f},
-        2.f, WHITE);
-    DrawTexture(asset_manager.textures[ASSET_ICON_HEALTH_TEXTURE], GetScreenWidth() - 140, GetScreenHeight() - 100,
-                WHITE);
-
-    // Kill bar.
-    DrawTexture(asset_manager.textures[ASSET_ICON_KILLS_TEXTURE], GetScreenWidth() - 140, GetScreenHeight() - 76,
-                WHITE);
-    DrawText(TextFormat("%d", kill_count), GetScreenWidth() - 116, GetScreenHeight() - 76, 20, WHITE);
-
-    // Bullet bar.
-    DrawTexture(asset_manager.textures[ASSET_ICON_BULLET_TEXTURE], GetScreenWidth() - 140, GetScreenHeight() - 52,
-                WHITE);
-    DrawText(TextFormat("%d", bullet_count), GetScreenWidth() - 116, GetScreenHeight() - 52, 20, WHITE);
-
-    // Mine bar.
-    DrawTexture(asset_manager.textures[ASSET_ICON_MINE_TEXTURE], GetScreenWidth() - 74, GetScreenHeight() - 52, WHITE);
-    DrawText(TextFormat("%d", mine_count), GetScreenWidth() - 50, GetScreenHeight() - 52, 20, WHITE);
-
-    // FPS bar.
-    DrawTexture(asset_manager.textures[ASSET_ICON_FPS_TEXTURE], GetScreenWidth() - 140, GetScreenHeight() - 28, WHITE);
-    DrawText(TextFormat("%d FPS", GetFPS()), GetScreenWidth() - 116, GetScreenHeight() - 28, 20, WHITE);
-
-    // Draw particles.
-    particle_manager->draw(map);
   }
 
-  void update_rotation() {
-    if (IsKeyDown(KEY_LEFT)) target_angle -= PLAYER_ANGLE_SPEED * GetFrameTime();
-    if (IsKeyDown(KEY_RIGHT)) target_angle += PLAYER_ANGLE_SPEED * GetFrameTime();
+  void update_rotation(FrameClock const &clock, InputState const &input) {
+    if (input.turn_left) target_angle -= PLAYER_ANGLE_SPEED * clock.dt;
+    if (input.turn_right) target_angle += PLAYER_ANGLE_SPEED * clock.dt;
+    if (input.turn_axis != 0.f) target_angle += PLAYER_ANGLE_SPEED * clock.dt * input.turn_axis;
+  }
 
-    if (IsGamepadAvailable(0)) {
-      float turn_axis = GetGamepadAxisMovement(0, GAMEPAD_AXIS_LEFT_X);
-      if (turn_axis != 0.f) target_angle += PLAYER_ANGLE_SPEED * GetFrameTime() * turn_axis;
+  void update_shooting(InputState const &input) {
+    // Rapid fire keeps its period only while held, the first burst shot follows the press instead of a running phase.
+    if (input.rapid_fire) {
+      rapid_fire_scheduler.resume();
+    } else {
+      rapid_fire_scheduler.pause();
     }
-  }
 
-  void update_shooting() {
     if (bullet_count <= 0) return;
 
-    if (IsKeyPressed(KEY_LEFT_CONTROL) || IsGamepadButtonPressed(0, 7)) {
+    if (input.shoot) {
       unconditional_shoot(BULLET_SINGLE_ATTACK_DAMAGE);
     }
 
-    if (IsKeyDown(KEY_LEFT_ALT) || IsGamepadButtonDown(0, 8)) {
-      rapid_fire_scheduler.update();
-      if (rapid_fire_scheduler.did_tick) {
+    if (input.rapid_fire) {
+      if (rapid_fire_scheduler.did_tick()) {
         unconditional_shoot(BULLET_BURST_ATTACK_DAMAGE);
       }
     }
   }
 
-  void update_mines() {
+  void update_mines(InputState const &input) {
     if (mine_count <= 0) return;
 
-    if (IsKeyPressed(KEY_LEFT_SHIFT)) {
+    if (input.drop_mine) {
       mines.emplace_back(*pos);
       mine_count--;
     }
@@ -182,23 +167,22 @@ struct Player {
     bullet_count--;
 
     float bullet_angle_rad = target_angle * DEG2RAD;
-    Vector2 bullet_v{cosf(bullet_angle_rad) * BULLET_SPEED * GetFrameTime(),
-                     sinf(bullet_angle_rad) * BULLET_SPEED * GetFrameTime()};
+    Vector2 bullet_v{cosf(bullet_angle_rad) * BULLET_SPEED, sinf(bullet_angle_rad) * BULLET_SPEED};
     bullets.emplace_back(*pos, bullet_v, attack_damage);
 
-    PlaySound(asset_manager.sounds[ASSET_SOUND_PLAYER_SHOOT]);
+    audio->play_sound(SoundId::PlayerShoot);
   }
 
-  void update_movement(Map const &map) {
+  void update_movement(FrameClock const &clock, Map const &map, InputState const &input) {
     const Vector2 old_pos = *pos;
 
     bool had_movement = false;
-    if (IsKeyDown(KEY_UP)) {
-      velocity += GetFrameTime() * 500.f;
+    if (input.forward) {
+      velocity += clock.dt * 500.f;
       had_movement = true;
     }
-    if (IsKeyDown(KEY_DOWN)) {
-      velocity -= GetFrameTime() * 500.f;
+    if (input.backward) {
+      velocity -= clock.dt * 500.f;
       had_movement = true;
     }
 
@@ -208,20 +192,20 @@ struct Player {
     // TraceLog(LOG_INFO, "GP0=%.2f %s", GetGamepadAxisMovement(0, GAMEPAD_AXIS_RIGHT_TRIGGER), GetGamepadName(0));
     //   float move_vertical_axis_fwd = GetGamepadAxisMovement(0, GAMEPAD_AXIS_RIGHT_TRIGGER);
     //   if (move_vertical_axis_fwd > -1.f) {
-    //     velocity += GetFrameTime() * 500.f * ((move_vertical_axis_fwd + 1.f) / 2.f);
+    //     velocity += clock.dt * 500.f * ((move_vertical_axis_fwd + 1.f) / 2.f);
     //     had_movement = true;
     //   }
     //
     //   float move_vertical_axis_bwd = GetGamepadAxisMovement(0, GAMEPAD_AXIS_LEFT_TRIGGER);
     //   if (move_vertical_axis_bwd > -1.f) {
-    //     velocity -= GetFrameTime() * 500.f * ((move_vertical_axis_bwd + 1.f) / 2.f);
+    //     velocity -= clock.dt * 500.f * ((move_vertical_axis_bwd + 1.f) / 2.f);
     //     had_movement = true;
     //   }
     // }
 
     // Apply velocity + angle.
-    pos->x += cosf(angle * DEG2RAD) * velocity * GetFrameTime();
-    pos->y += sinf(angle * DEG2RAD) * velocity * GetFrameTime();
+    pos->x += cosf(angle * DEG2RAD) * velocity * clock.dt;
+    pos->y += sinf(angle * DEG2RAD) * velocity * clock.dt;
 
     // Clamp velocity.
     if (velocity > PLAYER_MAX_SPEED) velocity = PLAYER_MAX_SPEED;
@@ -231,17 +215,19 @@ struct Player {
     if (had_movement) {
       angle = smoothstep(angle, target_angle, 0.1f);
     } else {
-      fps_independent_multiply(&velocity, 0.98f);
+      fps_independent_multiply(&velocity, 0.98f, clock.dt);
 
       if (fabs(velocity) < 60.f) velocity = 0.f;
     }
 
     if (!Vector2Equals(*pos, old_pos) && map.is_hit(*pos)) {
       float angle_left_attempt = (angle * DEG2RAD) - PLAYER_WALL_COLLIDE_ANGLE_ADJUST;
-      Vector2 left_attempt = point_move_with_angle_and_distance(old_pos, angle_left_attempt, 300.f * GetFrameTime());
+      Vector2 left_attempt =
+          point_move_with_angle_and_distance(old_pos, angle_left_attempt, 300.f * clock.dt);
 
       float angle_right_attempt = (angle * DEG2RAD) + PLAYER_WALL_COLLIDE_ANGLE_ADJUST;
-      Vector2 right_attempt = point_move_with_angle_and_distance(old_pos, angle_right_attempt, 300.f * GetFrameTime());
+      Vector2 right_attempt =
+          point_move_with_angle_and_distance(old_pos, angle_right_attempt, 300.f * clock.dt);
 
       if (!map.is_hit(left_attempt)) {
         // TraceLog(LOG_DEBUG, "Left glide | Angle=%.2f | TargetAngle=%.2f", angle, target_angle);
@@ -260,21 +246,19 @@ struct Player {
     }
 
     if (!Vector2Equals(*pos, old_pos)) {
-      wheel_trace_particle_scheduler.update();
-
-      if (wheel_trace_particle_scheduler.did_tick) {
-        particle_manager->particles.emplace_back(std::make_unique<TraceParticle>(*pos, angle + 90));
+      if (wheel_trace_particle_scheduler.did_tick()) {
+        particle_manager->spawn(std::make_unique<TraceParticle>(*pos, angle + 90));
       }
     }
   }
 
   void update_hurt_particles() {
-    if (hurt_particle_timed_repeater.update()) {
-      float angle_rad = (230 + rand() % 80) * DEG2RAD;
+    if (hurt_particle_timed_repeater.did_tick()) {
+      float angle_rad = (230 + cosmetic_rng.range(80)) * DEG2RAD;
       auto particle = std::make_unique<StraightLineParticle>(*pos, angle_rad, 400.f, 0.5);
       particle->speed_multiplier = 0.95f;
       particle->size = 2.f;
-      switch (rand() % 5) {
+      switch (cosmetic_rng.range(5)) {
         case 0:
           particle->color = YELLOW;
           break;
@@ -288,7 +272,7 @@ struct Player {
           particle->color = RED;
           break;
       }
-      particle_manager->particles.push_back(std::move(particle));
+      particle_manager->spawn(std::move(particle));
     }
   }
 
@@ -296,8 +280,8 @@ struct Player {
     return Vector2Add(*pos, world_offset);
   }
 
-  void hurt(AttackDamage const &thing) {
-    health -= thing.get_attack_damage();
+  void hurt(AttackDamage const &thing, FrameClock const &clock) {
+    health -= thing.get_attack_damage(clock);
 
     if (health <= 0) {
       health = 0;
@@ -0,0 +1,464 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "alloc_tracker.h"
+#include "raylib.h"
+
+// Zones compile to nothing unless the build asks for them (`make profile` or `make debug`).
+#if defined(PROFILE) || defined(DEBUG)
+#define PROFILER_ENABLED 1
+#else
+#define PROFILER_ENABLED 0
+#endif
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if PROFILER_ENABLED
+// Times the rest of the enclosing scope, nested under the zone open on this thread.
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+// Same, nested under `parent` - for work handed to another thread.
+#define PROFILE_ZONE_UNDER(name, parent) ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name, parent)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_ZONE_UNDER(name, parent)
+#endif
+
+#if defined(TRACK_ALLOCATIONS) && !PROFILER_ENABLED
+#error "Allocation tracking is reported through the profiler, build with PROFILE as well (make profile-alloc)"
+#endif
+
+#if PROFILER_ENABLED
+
+// Frames kept for the chart and the averages.
+constexpr int PROFILER_HISTORY = 100;
+constexpr int PROFILER_TOP_N = 8;
+// Node of the whole frame, every zone is below it.
+constexpr int PROFILER_ROOT = 0;
+constexpr float PROFILER_BAR_WIDTH = 2.f;
+constexpr float PROFILER_CHART_HEIGHT = 80.f;
+constexpr int PROFILER_MARGIN = 4;
+constexpr int PROFILER_FONT_SIZE = 10;
+// Colors of the top level zones in the stacked chart.
+constexpr std::array<Color, 6> PROFILER_PALETTE{SKYBLUE, ORANGE, LIME, PURPLE, GOLD, PINK};
+// Trace events kept in memory, the oldest are overwritten.
+constexpr int PROFILER_TRACE_CAPACITY = 1 << 18;
+// Only the last seconds of a capture are written.
+constexpr double PROFILER_TRACE_SECONDS = 10.0;
+constexpr const char *PROFILER_TRACE_FILE = "trace.json";
+
+// Zone open on the current thread.
+static thread_local int profile_current_zone{PROFILER_ROOT};
+// Trace thread id, in order of first use. The main thread is 0.
+static std::atomic<int> profile_thread_count{0};
+static thread_local int profile_thread_id{profile_thread_count.fetch_add(1)};
+
+enum class ProfilerSort { Total, Self };
+
+struct TraceEvent {
+  const char *name;
+  // Chrome trace event phase: 'X' complete event or 'C' counter.
+  char phase;
+  int thread;
+  int64_t ts_us;
+  int64_t dur_us;
+  double value;
+  // Complete events, with allocation tracking only.
+  AllocCounters allocs;
+};
+
+/**
+ * Hierarchical frame profiler. Every distinct path of nested zones is a node of a tree which lives for the whole
+ * run, zones add their time to their node. At the end of a frame the node times are moved into a history of
+ * `PROFILER_HISTORY` frames, which the overlay draws from.
+ *
+ * While tracing, zones, frames and counters are also recorded into a ring buffer of trace events, written as Chrome
+ * trace JSON (chrome://tracing, ui.perfetto.dev) when the capture stops.
+ */
+struct Profiler {
+  struct Node {
+    const char *name;
+    int parent;
+    int depth;
+    double frame_ms{0.0};
+    int frame_calls{0};
+    int last_calls{0};
+    // Allocations of the zone and its children, with allocation tracking only.
+    AllocCounters frame_allocs{};
+    AllocCounters last_allocs{};
+    std::array<float, PROFILER_HISTORY> history{};
+  };
+
+  ProfilerSort sort{ProfilerSort::Total};
+  std::string trace_file{PROFILER_TRACE_FILE};
+  double trace_seconds{PROFILER_TRACE_SECONDS};
+
+  // Constructed on the main thread, which takes trace thread id 0.
+  Profiler() : epoch(std::chrono::steady_clock::now()) {
+    nodes.push_back(Node{"frame", -1, 0});
+    (void)profile_thread_id;
+  }
+
+  // Node of `name` below `parent`, created on first use. Names are string literals or otherwise outlive the run, so
+  // each thread caches the node per name pointer and only takes the lock the first time it opens a zone there.
+  int begin_zone(const char *name, int parent) {
+    static thread_local std::unordered_map<ZoneKey, int, ZoneKeyHash> cache{};
+    auto cached = cache.find(ZoneKey{name, parent});
+    if (cached != cache.end()) return cached->second;
+
+    const int node = find_or_add_node(name, parent);
+    cache.emplace(ZoneKey{name, parent}, node);
+    return node;
+  }
+
+  void end_zone(int node, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end,
+                AllocCounters const &allocs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Node &zone = nodes[node];
+    zone.frame_ms += std::chrono::duration<double, std::milli>(end - start).count();
+    zone.frame_calls++;
+    zone.frame_allocs = AllocCounters{zone.frame_allocs.allocs + allocs.allocs, zone.frame_allocs.bytes + allocs.bytes,
+                                      zone.frame_allocs.frees + allocs.frees};
+    if (tracing) {
+      record(TraceEvent{zone.name, 'X', profile_thread_id, micros(start), micros(end) - micros(start), 0.0, allocs});
+    }
+  }
+
+  // Traced only, e.g. entity counts once per frame.
+  void counter(const char *name, double value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tracing) record(TraceEvent{name, 'C', profile_thread_id, micros(std::chrono::steady_clock::now()), 0, value});
+  }
+
+  // Calls of the zones called `name` so far in the current frame.
+  [[nodiscard]] int frame_calls(const char *name) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    int calls{0};
+    for (auto const &node : nodes) {
+      if (strcmp(node.name, name) == 0) calls += node.frame_calls;
+    }
+    return calls;
+  }
+
+  [[nodiscard]] bool is_tracing() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tracing;
+  }
+
+  void start_trace() {
+    std::lock_guard<std::mutex> lock(mutex);
+    trace_events.resize(PROFILER_TRACE_CAPACITY);
+    trace_head = 0;
+    trace_size = 0;
+    tracing = true;
+    TraceLog(LOG_INFO, "Trace capture started");
+  }
+
+  // Writes the last `trace_seconds` of the capture to `trace_file`.
+  void stop_trace() {
+    std::vector<TraceEvent> events{};
+    int first{0};
+    int count{0};
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!tracing) return;
+
+      tracing = false;
+      events.swap(trace_events);
+      first = (trace_head - trace_size + PROFILER_TRACE_CAPACITY) % PROFILER_TRACE_CAPACITY;
+      count = trace_size;
+    }
+    // Formatting a full ring takes a while, zones closing on other threads must not wait for it.
+    write_trace(events, first, count);
+  }
+
+  void toggle_trace() {
+    if (is_tracing()) {
+      stop_trace();
+    } else {
+      start_trace();
+    }
+  }
+
+  void begin_frame() {
+    frame_start = std::chrono::steady_clock::now();
+  }
+
+  // After the buffer swap, so the frame time includes waiting for vsync.
+  void end_frame() {
+    const double frame_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count();
+    const AllocCounters frame_end_allocs = total_alloc_counters();
+    const AllocCounters frame_allocs = frame_end_allocs - frame_start_allocs;
+    frame_start_allocs = frame_end_allocs;
+#if ALLOC_TRACKING_ENABLED
+    counter("allocations", static_cast<double>(frame_allocs.allocs));
+    counter("alloc_bytes", static_cast<double>(frame_allocs.bytes));
+    counter("frees", static_cast<double>(frame_allocs.frees));
+#endif
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tracing) {
+      record(TraceEvent{nodes[PROFILER_ROOT].name, 'X', profile_thread_id, micros(frame_start),
+                        static_cast<int64_t>(frame_ms * 1000.0), 0.0, frame_allocs});
+    }
+    nodes[PROFILER_ROOT].frame_ms = frame_ms;
+    nodes[PROFILER_ROOT].frame_calls = 1;
+    nodes[PROFILER_ROOT].frame_allocs = frame_allocs;
+    for (auto &node : nodes) {
+      node.history[frame_idx] = static_cast<float>(node.frame_ms);
+      node.last_calls = node.frame_calls;
+      node.last_allocs = node.frame_allocs;
+      node.frame_allocs = AllocCounters{};
+      node.frame_ms = 0.0;
+      node.frame_calls = 0;
+    }
+    frame_idx = (frame_idx + 1) % PROFILER_HISTORY;
+    frame_count = std::min(frame_count + 1, PROFILER_HISTORY);
+  }
+
+  void toggle_sort() {
+    sort = sort == ProfilerSort::Total ? ProfilerSort::Self : ProfilerSort::Total;
+  }
+
+  // Stacked chart of the top level zones per frame, and the most expensive zones on average.
+  void draw() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (frame_count == 0) return;
+
+    const int chart_width = static_cast<int>(PROFILER_HISTORY * PROFILER_BAR_WIDTH);
+    const int left = GetScreenWidth() - chart_width - PROFILER_MARGIN * 2 - 180;
+    const int top = PROFILER_MARGIN;
+    const int table_height = (PROFILER_TOP_N + 1 + ALLOC_TRACKING_ENABLED) * (PROFILER_FONT_SIZE + 2);
+    DrawRectangle(left - PROFILER_MARGIN, top, chart_width + 180 + PROFILER_MARGIN * 3,
+                  PROFILER_CHART_HEIGHT + table_height + PROFILER_MARGIN * 3, ColorAlpha(BLACK, 0.5f));
+
+    // The slowest frame in the history fills the chart.
+    float scale_ms = 0.f;
+    for (int i = 0; i < frame_count; i++) scale_ms = std::max(scale_ms, nodes[PROFILER_ROOT].history[i]);
+    scale_ms = std::max(scale_ms, 1.f);
+    const float chart_bottom = top + PROFILER_MARGIN + PROFILER_CHART_HEIGHT;
+
+    for (int frame = 0; frame < frame_count; frame++) {
+      // Oldest frame first.
+      const int idx = (frame_idx - frame_count + frame + PROFILER_HISTORY) % PROFILER_HISTORY;
+      const float x = left + (PROFILER_HISTORY - frame_count + frame) * PROFILER_BAR_WIDTH;
+      float y = chart_bottom;
+      int color_idx = 0;
+      for (int i = 1; i < static_cast<int>(nodes.size()); i++) {
+        if (nodes[i].parent != PROFILER_ROOT) continue;
+
+        const float height = nodes[i].history[idx] / scale_ms * PROFILER_CHART_HEIGHT;
+        y -= height;
+        DrawRectangleV(Vector2{x, y}, Vector2{PROFILER_BAR_WIDTH, height},
+                       PROFILER_PALETTE[color_idx++ % PROFILER_PALETTE.size()]);
+      }
+      // Rest of the frame, outside any zone.
+      const float frame_top = chart_bottom - nodes[PROFILER_ROOT].history[idx] / scale_ms * PROFILER_CHART_HEIGHT;
+      if (frame_top < y) DrawRectangleV(Vector2{x, frame_top}, Vector2{PROFILER_BAR_WIDTH, y - frame_top}, DARKGRAY);
+    }
+
+    // Legend of the top level zones.
+    int legend_y = top + PROFILER_MARGIN;
+    int color_idx = 0;
+    for (int i = 1; i < static_cast<int>(nodes.size()); i++) {
+      if (nodes[i].parent != PROFILER_ROOT) continue;
+
+      const int legend_x = left + chart_width + PROFILER_MARGIN;
+      DrawRectangle(legend_x, legend_y, PROFILER_FONT_SIZE, PROFILER_FONT_SIZE,
+                    PROFILER_PALETTE[color_idx++ % PROFILER_PALETTE.size()]);
+      DrawText(TextFormat("%s %.2f ms", nodes[i].name, average(i)), legend_x + PROFILER_FONT_SIZE + 4, legend_y,
+               PROFILER_FONT_SIZE, WHITE);
+      legend_y += PROFILER_FONT_SIZE + 2;
+    }
+
+    // Top N table.
+    std::vector<int> order(nodes.size());
+    for (int i = 0; i < static_cast<int>(nodes.size()); i++) order[i] = i;
+    std::vector<float> keys(nodes.size());
+    for (int i = 0; i < static_cast<int>(nodes.size()); i++) {
+      keys[i] = sort == ProfilerSort::Total ? average(i) : self_average(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int lhs, int rhs) { return keys[lhs] > keys[rhs]; });
+
+    int row_y = static_cast<int>(chart_bottom) + PROFILER_MARGIN;
+#if ALLOC_TRACKING_ENABLED
+    AllocCounters const &frame_allocs = nodes[PROFILER_ROOT].last_allocs;
+    DrawText(TextFormat("last frame: %llu allocs, %.1f KB, %llu frees",
+                        static_cast<unsigned long long>(frame_allocs.allocs), frame_allocs.bytes / 1024.0,
+                        static_cast<unsigned long long>(frame_allocs.frees)),
+             left, row_y, PROFILER_FONT_SIZE, LIGHTGRAY);
+    row_y += PROFILER_FONT_SIZE + 2;
+#endif
+    DrawText(TextFormat("zone (sorted by %s, F2)             total     self  calls%s",
+                        sort == ProfilerSort::Total ? "total" : "self", ALLOC_TRACKING_ENABLED ? "  allocs" : ""),
+             left, row_y, PROFILER_FONT_SIZE, LIGHTGRAY);
+    for (int row = 0; row < std::min(PROFILER_TOP_N, static_cast<int>(order.size())); row++) {
+      row_y += PROFILER_FONT_SIZE + 2;
+      Node const &node = nodes[order[row]];
+      DrawText(TextFormat("%*s%s", node.depth * 2, "", node.name), left, row_y, PROFILER_FONT_SIZE, WHITE);
+      DrawText(TextFormat("%6.2f ms %6.2f ms %5d", average(order[row]), self_average(order[row]), node.last_calls),
+               left + 190, row_y, PROFILER_FONT_SIZE, WHITE);
+#if ALLOC_TRACKING_ENABLED
+      DrawText(TextFormat("%6llu", static_cast<unsigned long long>(node.last_allocs.allocs)), left + 330, row_y,
+               PROFILER_FONT_SIZE, WHITE);
+#endif
+    }
+  }
+
+ private:
+  std::vector<Node> nodes{};
+  int frame_idx{0};
+  int frame_count{0};
+  std::chrono::steady_clock::time_point epoch;
+  std::chrono::steady_clock::time_point frame_start{};
+  AllocCounters frame_start_allocs{};
+  bool tracing{false};
+  std::vector<TraceEvent> trace_events{};
+  int trace_head{0};
+  int trace_size{0};
+  mutable std::mutex mutex{};
+
+  using ZoneKey = std::pair<const char *, int>;
+  struct ZoneKeyHash {
+    size_t operator()(ZoneKey const &key) const {
+      return std::hash<const char *>{}(key.first) ^ (std::hash<int>{}(key.second) * 0x9e3779b97f4a7c15ull);
+    }
+  };
+
+  // Zones are matched by name, two literals with the same text share their node.
+  int find_or_add_node(const char *name, int parent) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int i = 0; i < static_cast<int>(nodes.size()); i++) {
+      if (nodes[i].parent == parent && strcmp(nodes[i].name, name) == 0) return i;
+    }
+
+    nodes.push_back(Node{name, parent, nodes[parent].depth + 1});
+    return static_cast<int>(nodes.size()) - 1;
+  }
+
+  [[nodiscard]] int64_t micros(std::chrono::steady_clock::time_point time) const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time - epoch).count();
+  }
+
+  void record(TraceEvent const &event) {
+    trace_events[trace_head] = event;
+    trace_head = (trace_head + 1) % PROFILER_TRACE_CAPACITY;
+    trace_size = std::min(trace_size + 1, PROFILER_TRACE_CAPACITY);
+  }
+
+  // `count` events of the ring `events`, the oldest at `first`.
+  void write_trace(std::vector<TraceEvent> const &events, int first, int count) const {
+    FILE *file = fopen(trace_file.c_str(), "w");
+    if (!file) {
+      TraceLog(LOG_WARNING, "Cannot write trace: %s", trace_file.c_str());
+      return;
+    }
+
+    int64_t last_ts{0};
+    for (int i = 0; i < count; i++) {
+      last_ts = std::max(last_ts, events[(first + i) % PROFILER_TRACE_CAPACITY].ts_us);
+    }
+    const int64_t window_start = last_ts - static_cast<int64_t>(trace_seconds * 1e6);
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    // Thread names.
+    const int thread_count = profile_thread_count.load();
+    for (int thread = 0; thread < thread_count; thread++) {
+      fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}",
+              thread > 0 ? ",\n" : "", thread, thread == 0 ? "main" : "worker", thread);
+    }
+
+    int written{0};
+    for (int i = 0; i < count; i++) {
+      TraceEvent const &event = events[(first + i) % PROFILER_TRACE_CAPACITY];
+      if (event.ts_us < window_start) continue;
+
+      written++;
+      fprintf(file, ",\n");
+      if (event.phase == 'X') {
+        fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lld,\"dur\":%lld", event.name,
+                event.thread, static_cast<long long>(event.ts_us), static_cast<long long>(event.dur_us));
+#if ALLOC_TRACKING_ENABLED
+        fprintf(file, ",\"args\":{\"allocs\":%llu,\"alloc_bytes\":%llu,\"frees\":%llu}",
+                static_cast<unsigned long long>(event.allocs.allocs),
+                static_cast<unsigned long long>(event.allocs.bytes),
+                static_cast<unsigned long long>(event.allocs.frees));
+#endif
+        fprintf(file, "}");
+      } else {
+        fprintf(file, "{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%lld,\"args\":{\"value\":%g}}",
+                event.name, event.thread, static_cast<long long>(event.ts_us), event.value);
+      }
+    }
+    fprintf(file, "\n]}\n");
+
+    if (fclose(file) != 0) {
+      TraceLog(LOG_WARNING, "Cannot write trace: %s", trace_file.c_str());
+      return;
+    }
+    TraceLog(LOG_INFO, "Trace of %d events written to %s", written, trace_file.c_str());
+  }
+
+  [[nodiscard]] float average(int node) const {
+    float sum = 0.f;
+    for (int i = 0; i < frame_count; i++) sum += nodes[node].history[i];
+    return sum / frame_count;
+  }
+
+  // Time not spent in child zones.
+  [[nodiscard]] float self_average(int node) const {
+    float self = average(node);
+    for (int i = node + 1; i < static_cast<int>(nodes.size()); i++) {
+      if (nodes[i].parent == node) self -= average(i);
+    }
+    return std::max(0.f, self);
+  }
+};
+
+static Profiler profiler{};
+
+/**
+ * RAII zone, use through `PROFILE_ZONE`.
+ */
+struct ProfileZone {
+  explicit ProfileZone(const char *name) : ProfileZone(name, profile_current_zone) {
+  }
+
+  ProfileZone(const char *name, int parent)
+      : node(profiler.begin_zone(name, parent)),
+        previous(profile_current_zone),
+        start(std::chrono::steady_clock::now()),
+        start_allocs(thread_alloc_counters) {
+    profile_current_zone = node;
+  }
+
+  ProfileZone(ProfileZone const &) = delete;
+  ProfileZone &operator=(ProfileZone const &) = delete;
+
+  ~ProfileZone() {
+    const AllocCounters allocs = thread_alloc_counters - start_allocs;
+    profiler.end_zone(node, start, std::chrono::steady_clock::now(), allocs);
+    profile_current_zone = previous;
+  }
+
+ private:
+  int node;
+  int previous;
+  std::chrono::steady_clock::time_point start;
+  AllocCounters start_allocs;
+};
+
+#endif
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <array>
+
+#include "raylib.h"
+
+// rlgl's default batch: draw call entries and vertices (quads of 4) before it flushes on its own.
+constexpr int RENDER_BATCH_MAX_DRAWS = 256;
+constexpr int RENDER_BATCH_MAX_VERTICES = 8192 * 4;
+// raylib draws a circle as 36 segments, in pairs as quads.
+constexpr int RENDER_CIRCLE_VERTICES = 18 * 4;
+constexpr int RENDER_STATS_FONT_SIZE = 10;
+
+enum class RenderPass { Map, Enemies, Objects, Particles, Hud, Minimap, Other, Count };
+
+constexpr const char *RENDER_PASS_NAMES[static_cast<int>(RenderPass::Count)]{
+    "map", "enemies", "objects", "particles", "hud", "minimap", "other",
+};
+
+// Primitive mode of a batched draw. Shapes and sprites are quads, thick lines are triangles.
+enum class RenderMode { Quads, Triangles };
+
+struct RenderCounters {
+  // Draw call entries of the batch, each a separate GL draw: started by a texture or primitive mode change.
+  int draw_calls{};
+  int texture_switches{};
+  int vertices{};
+  // Batch submissions to the GPU: end of frame, render texture changes and overflowing batches.
+  int flushes{};
+
+  RenderCounters &operator+=(RenderCounters const &rhs) {
+    draw_calls += rhs.draw_calls;
+    texture_switches += rhs.texture_switches;
+    vertices += rhs.vertices;
+    flushes += rhs.flushes;
+    return *this;
+  }
+};
+
+/**
+ * Render cost of a frame per draw pass. rlgl does not expose its batch counters, so the draw sites report what they
+ * submit and this replays rlgl's batching rules on it: a new draw call on every texture or mode change, a flush on
+ * render texture changes, at the end of the frame and when the batch runs full. Debug overlays are not counted, the
+ * numbers are those of a release frame.
+ */
+struct RenderStats {
+  // Set once the textures exist: the atlas shapes are drawn with, and the default font.
+  unsigned int shapes_texture_id{0};
+  unsigned int font_texture_id{0};
+
+  // At the start of the frame, before any render texture updates.
+  void begin_frame() {
+    current = {};
+    pass = RenderPass::Other;
+  }
+
+  // Just before `EndDrawing`, which flushes the batch. Publishes the frame.
+  void end_frame() {
+    set_pass(RenderPass::Other);
+    flush();
+    last = current;
+    last_total = RenderCounters{};
+    for (auto const &counters : last) last_total += counters;
+  }
+
+  void set_pass(RenderPass _pass) {
+    pass = _pass;
+  }
+
+  void quads(unsigned int texture_id, int count = 1) {
+    record(texture_id, RenderMode::Quads, count * 4);
+  }
+
+  void shape_quads(int count = 1) {
+    quads(shapes_texture_id, count);
+  }
+
+  void circle() {
+    record(shapes_texture_id, RenderMode::Quads, RENDER_CIRCLE_VERTICES);
+  }
+
+  void line() {
+    record(shapes_texture_id, RenderMode::Triangles, 6);
+  }
+
+  // A quad per visible glyph.
+  void text(const char *text) {
+    int glyphs{0};
+    for (const char *c = text; *c; c++) {
+      if (*c != ' ' && *c != '\t' && *c != '\n') glyphs++;
+    }
+    quads(font_texture_id, glyphs);
+  }
+
+  // `BeginTextureMode`, `EndTextureMode` and `EndDrawing` submit the batch.
+  void flush() {
+    if (batch_draws > 0) counters().flushes++;
+    batch_draws = 0;
+    batch_vertices = 0;
+    // rlgl starts the next batch on its default texture.
+    batch_texture = 0;
+  }
+
+  [[nodiscard]] RenderCounters const &frame_totals() const {
+    return last_total;
+  }
+
+  [[nodiscard]] RenderCounters const &frame_pass(RenderPass _pass) const {
+    return last[static_cast<int>(_pass)];
+  }
+
+  // A table of the last frame, growing upwards from `bottom`.
+  void draw(int left, int bottom) const {
+    const int line_h = RENDER_STATS_FONT_SIZE + 2;
+    const int rows = static_cast<int>(RenderPass::Count) + 2;
+    const int top = bottom - rows * line_h;
+    DrawRectangle(left, top - 4, 300, rows * line_h + 4, ColorAlpha(BLACK, 0.4f));
+
+    auto row = [&](int i, const char *name, RenderCounters const &counters) {
+      DrawText(TextFormat("%-10s %6d %6d %8d %6d", name, counters.draw_calls, counters.texture_switches,
+                          counters.vertices, counters.flushes),
+               left + 4, top + i * line_h, RENDER_STATS_FONT_SIZE, WHITE);
+    };
+    DrawText("pass        draws  texsw    verts flushes", left + 4, top, RENDER_STATS_FONT_SIZE, LIGHTGRAY);
+    for (int i = 0; i < static_cast<int>(RenderPass::Count); i++) row(i + 1, RENDER_PASS_NAMES[i], last[i]);
+    row(rows - 1, "total", last_total);
+  }
+
+ private:
+  std::array<RenderCounters, static_cast<int>(RenderPass::Count)> current{};
+  std::array<RenderCounters, static_cast<int>(RenderPass::Count)> last{};
+  RenderCounters last_total{};
+  RenderPass pass{RenderPass::Other};
+
+  unsigned int batch_texture{0};
+  RenderMode batch_mode{RenderMode::Quads};
+  int batch_draws{0};
+  int batch_vertices{0};
+
+  RenderCounters &counters() {
+    return current[static_cast<int>(pass)];
+  }
+
+  void record(unsigned int texture_id, RenderMode mode, int vertices) {
+    if (vertices == 0) return;
+
+    RenderCounters &pass_counters = counters();
+    if (batch_vertices + vertices > RENDER_BATCH_MAX_VERTICES) flush();
+
+    const bool texture_switch = texture_id != batch_texture;
+    if (texture_switch || mode != batch_mode || batch_draws == 0) {
+      if (batch_draws == RENDER_BATCH_MAX_DRAWS) flush();
+      if (texture_switch) pass_counters.texture_switches++;
+      pass_counters.draw_calls++;
+      batch_draws++;
+      batch_texture = texture_id;
+      batch_mode = mode;
+    }
+
+    pass_counters.vertices += vertices;
+    batch_vertices += vertices;
+  }
+};
+
+static RenderStats render_stats{};
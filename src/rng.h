@@ -0,0 +1,69 @@
+#pragma once
+
+#include <sys/types.h>
+
+/**
+ * PCG32 random generator (https://www.pcg-random.org). Small, fast and seedable; different `stream` values give
+ * independent sequences for the same seed.
+ */
+struct Rng {
+  u_int64_t state{0};
+  u_int64_t inc{1};
+
+  Rng() : Rng(0, 0) {
+  }
+
+  Rng(u_int64_t seed, u_int64_t stream) {
+    reseed(seed, stream);
+  }
+
+  void reseed(u_int64_t seed, u_int64_t stream) {
+    state = 0;
+    inc = (stream << 1u) | 1u;
+    next();
+    state += seed;
+    next();
+  }
+
+  u_int32_t next() {
+    u_int64_t old_state = state;
+    state = old_state * 6364136223846793005ULL + inc;
+    auto xorshifted = static_cast<u_int32_t>(((old_state >> 18u) ^ old_state) >> 27u);
+    auto rot = static_cast<u_int32_t>(old_state >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+  }
+
+  /**
+   * Returns a random between 0.0 (included) and 1.0 (excluded).
+   */
+  float unit() {
+    return static_cast<float>(next() >> 8) * (1.f / 16777216.f);
+  }
+
+  /**
+   * Returns a random integer between 0 (included) and `n` (excluded).
+   */
+  int range(int n) {
+    return static_cast<int>((static_cast<u_int64_t>(next()) * static_cast<u_int64_t>(n)) >> 32);
+  }
+
+  // A new generator with its own seed and stream, derived from this one.
+  Rng fork() {
+    u_int64_t seed = (static_cast<u_int64_t>(next()) << 32) | next();
+    u_int64_t stream = (static_cast<u_int64_t>(next()) << 32) | next();
+    return Rng(seed, stream);
+  }
+};
+
+constexpr u_int64_t RNG_STREAM_GAMEPLAY = 1;
+constexpr u_int64_t RNG_STREAM_COSMETIC = 2;
+
+// Everything that affects the outcome of a match: spawns, AI decisions, timer jitter.
+static Rng gameplay_rng{0, RNG_STREAM_GAMEPLAY};
+// Visual only (particles, zapper bolts) - adding or removing effects never changes gameplay.
+static Rng cosmetic_rng{0, RNG_STREAM_COSMETIC};
+
+void seed_rngs(u_int64_t seed) {
+  gameplay_rng.reseed(seed, RNG_STREAM_GAMEPLAY);
+  cosmetic_rng.reseed(seed, RNG_STREAM_COSMETIC);
+}
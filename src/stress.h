@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "raylib.h"
+#include "tuning.h"
+
+/**
+ * How the stress mode ramps the entity counts, read from a settings file (see `read_settings_file`) with the keys
+ * below. Unset keys keep their defaults.
+ */
+struct StressConfig {
+  // Mean tick time the simulation must stay within. Half of a 60 Hz frame, leaving the other half for drawing.
+  double budget_ms{8.0};
+  // Ticks measured at every entity count.
+  int step_ticks{120};
+  // A ramp gives up after this many steps, even within budget.
+  int max_steps{40};
+  // Entity count added per step, per ramped kind.
+  int enemy_step{25};
+  int bullet_step{250};
+  int particle_step{1000};
+
+  static StressConfig from_file(std::string const &path) {
+    StressConfig config{};
+    read_settings_file(path, [&](const char *key, const char *value) {
+      if (strcmp(key, "budget_ms") == 0) {
+        config.budget_ms = atof(value);
+      } else if (strcmp(key, "step_ticks") == 0) {
+        config.step_ticks = std::max(1, atoi(value));
+      } else if (strcmp(key, "max_steps") == 0) {
+        config.max_steps = std::max(1, atoi(value));
+      } else if (strcmp(key, "enemy_step") == 0) {
+        config.enemy_step = std::max(1, atoi(value));
+      } else if (strcmp(key, "bullet_step") == 0) {
+        config.bullet_step = std::max(1, atoi(value));
+      } else if (strcmp(key, "particle_step") == 0) {
+        config.particle_step = std::max(1, atoi(value));
+      } else {
+        return false;
+      }
+      return true;
+    });
+    return config;
+  }
+};
+
+// One step of a ramp: the tick cost at an entity count.
+struct StressPoint {
+  int count{};
+  double tick_mean_ms{};
+  double tick_p95_ms{};
+  // The most expensive tick phase at this count, and its mean time per tick.
+  std::string top_phase{};
+  double top_phase_ms{};
+};
+
+// Scaling curve of one entity kind, ramped until the tick went over budget.
+struct StressCurve {
+  std::string kind{};
+  std::vector<StressPoint> points{};
+  // Highest count within budget, and the count which broke it. `break_count` is 0 when the ramp never broke.
+  int capacity{0};
+  int break_count{0};
+};
+
+inline void write_stress_report(std::string const &path, StressConfig const &config,
+                                std::vector<StressCurve> const &curves) {
+  FILE *file = fopen(path.c_str(), "w");
+  if (!file) {
+    TraceLog(LOG_ERROR, "Cannot write stress report: %s", path.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  fprintf(file, "{\n  \"build\": ");
+  BenchBuild::current().write(file);
+  fprintf(file, ",\n  \"budget_ms\": %.3f,\n  \"step_ticks\": %d,\n  \"curves\": [\n", config.budget_ms,
+          config.step_ticks);
+  for (unsigned int i = 0; i < curves.size(); i++) {
+    StressCurve const &curve = curves[i];
+    fprintf(file, "    {\n");
+    fprintf(file, "      \"kind\": \"%s\",\n", curve.kind.c_str());
+    fprintf(file, "      \"capacity\": %d,\n", curve.capacity);
+    fprintf(file, "      \"break_count\": %d,\n", curve.break_count);
+    fprintf(file, "      \"points\": [\n");
+    for (unsigned int p = 0; p < curve.points.size(); p++) {
+      StressPoint const &point = curve.points[p];
+      fprintf(file,
+              "        {\"count\": %d, \"tick_mean_ms\": %.4f, \"tick_p95_ms\": %.4f, \"top_phase\": \"%s\", "
+              "\"top_phase_ms\": %.4f}%s\n",
+              point.count, point.tick_mean_ms, point.tick_p95_ms, point.top_phase.c_str(), point.top_phase_ms,
+              p + 1 < curve.points.size() ? "," : "");
+    }
+    fprintf(file, "      ]\n");
+    fprintf(file, "    }%s\n", i + 1 < curves.size() ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+
+  if (fclose(file) != 0) {
+    TraceLog(LOG_ERROR, "Cannot write stress report: %s", path.c_str());
+    exit(EXIT_FAILURE);
+  }
+}
@@ -0,0 +1,149 @@
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../bench.h"
+#include "../json.h"
+
+using namespace std;
+
+static int failures{0};
+
+static void check(bool ok, const char *what) {
+  cout << (ok ? "ok   " : "FAIL ") << what << endl;
+  if (!ok) failures++;
+}
+
+static bool parse(string const &text, JsonValue &out) {
+  JsonParser parser{text};
+  return parser.parse(out);
+}
+
+// A baseline report as `write_bench_report` writes it, trimmed to what the gate reads.
+static const string BASELINE = R"({
+  "scenarios": [
+    {
+      "name": "steady",
+      "seed": 1,
+      "threads": 4,
+      "metrics": {"tick_ms.mean": {"median": 1.0000, "noise": 0.0100},
+                  "phase_ms.enemies": {"median": 0.0100, "noise": 0.0000}},
+      "final": {"enemies": 12, "kills": -3, "health": 1.5e1}
+    },
+    {
+      "name": "noisy",
+      "metrics": {"tick_ms.mean": {"median": 1.0000, "noise": 0.1000}}
+    }
+  ],
+  "note": "escaped \"quote\"",
+  "flags": [true, false, null]
+})";
+
+static BenchResult scenario_result(const char *scenario, vector<BenchMetric> metrics) {
+  BenchResult result{};
+  result.scenario.name = scenario;
+  result.metrics = std::move(metrics);
+  return result;
+}
+
+static void test_parser() {
+  JsonValue root{};
+  check(parse(BASELINE, root), "report parses");
+
+  JsonValue const *scenarios = root.find("scenarios");
+  check(scenarios && scenarios->type == JsonValue::Type::Array && scenarios->items.size() == 2, "scenarios array");
+
+  JsonValue const &steady = scenarios->items[0];
+  check(steady.find("name")->string == "steady", "string member");
+  check(steady.number_or("threads", 0.0) == 4.0 && steady.number_or("missing", -1.0) == -1.0, "number_or");
+  JsonValue const *final_state = steady.find("final");
+  check(final_state->number_or("kills", 0.0) == -3.0 && final_state->number_or("health", 0.0) == 15.0,
+        "negative and exponent numbers");
+  check(steady.find("metrics")->find("tick_ms.mean")->number_or("noise", 0.0) == 0.01, "nested objects");
+  check(root.find("note")->string == "escaped \"quote\"", "escaped quote");
+
+  JsonValue const *flags = root.find("flags");
+  check(flags->items.size() == 3 && flags->items[0].boolean && !flags->items[1].boolean &&
+            flags->items[2].type == JsonValue::Type::Null,
+        "literals");
+
+  JsonValue invalid{};
+  check(!parse("{\"a\": 1,}", invalid), "trailing comma is rejected");
+  check(!parse("{\"a\": inf}", invalid) && !parse("[-nan]", invalid) && !parse("[0x10]", invalid),
+        "inf, nan and hex are rejected");
+  check(!parse("[1e999]", invalid), "out of range number is rejected");
+  check(!parse("[1] 2", invalid), "trailing content is rejected");
+}
+
+static void test_gate() {
+  JsonValue root{};
+  parse(BASELINE, root);
+  JsonValue const &scenarios = *root.find("scenarios");
+  BenchGate gate{};
+
+  // max(5% of 1.0, 3 * sqrt(0.01^2 + 0.01^2), 0.005): the slowdown bound of 0.05 applies.
+  check(gate.compare_scenarios(scenarios, {scenario_result("steady", {{"tick_ms.mean", 1.04, 0.01}})}) == 0,
+        "4% slower than a steady baseline passes");
+  check(gate.compare_scenarios(scenarios, {scenario_result("steady", {{"tick_ms.mean", 1.06, 0.01}})}) == 1,
+        "6% slower than a steady baseline fails");
+  check(gate.compare_scenarios(scenarios, {scenario_result("steady", {{"tick_ms.mean", 0.50, 0.01}})}) == 0,
+        "faster passes");
+
+  // 3 * sqrt(0.1^2 + 0.1^2) = 0.42: the noise bound applies.
+  check(gate.compare_scenarios(scenarios, {scenario_result("noisy", {{"tick_ms.mean", 1.40, 0.1}})}) == 0,
+        "40% slower within the noise passes");
+  check(gate.compare_scenarios(scenarios, {scenario_result("noisy", {{"tick_ms.mean", 1.45, 0.1}})}) == 1,
+        "45% slower beyond the noise fails");
+
+  // 5% of 0.01 is below the 0.005 ms floor.
+  check(gate.compare_scenarios(scenarios, {scenario_result("steady", {{"phase_ms.enemies", 0.014, 0.0}})}) == 0,
+        "tiny phase within the minimum delta passes");
+  check(gate.compare_scenarios(scenarios, {scenario_result("steady", {{"phase_ms.enemies", 0.016, 0.0}})}) == 1,
+        "tiny phase beyond the minimum delta fails");
+
+  const vector<BenchResult> missing{scenario_result("new", {{"tick_ms.mean", 1.0, 0.0}}),
+                                    scenario_result("steady", {{"phase_ms.audio", 0.1, 0.0}})};
+  check(gate.compare_scenarios(scenarios, missing) == 2, "missing scenario and metric fail");
+  gate.allow_missing = true;
+  check(gate.compare_scenarios(scenarios, missing) == 0, "missing scenario and metric are skipped when allowed");
+}
+
+// The `build` object of a report, as `BenchBuild::write` writes it.
+static JsonValue build_json(BenchBuild const &build) {
+  char *text{nullptr};
+  size_t size{0};
+  FILE *file = open_memstream(&text, &size);
+  build.write(file);
+  fclose(file);
+
+  JsonValue value{};
+  parse(string(text, size), value);
+  free(text);
+  return value;
+}
+
+static void test_build() {
+  const BenchBuild build = BenchBuild::current();
+  cout << "this build: " << build.describe() << endl;
+  check(BenchBuild::of(build_json(build)) == build, "report of this build matches");
+
+  BenchBuild profiled = build;
+  profiled.profile = !profiled.profile;
+  check(BenchBuild::of(build_json(profiled)) != build, "report with the profiler toggled does not match");
+
+  BenchBuild optimized = build;
+  optimized.opt_level = build.opt_level == 2 ? 0 : 2;
+  check(BenchBuild::of(build_json(optimized)) != build, "report of another -O level does not match");
+  check(BenchBuild::of(JsonValue{}) != build, "report without a build matches none");
+}
+
+int main() {
+  test_parser();
+  test_gate();
+  test_build();
+
+  cout << (failures == 0 ? "All passed" : "Failed") << endl;
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
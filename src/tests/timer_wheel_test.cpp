@@ -0,0 +1,170 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "../common.h"
+#include "../timer_wheel.h"
+
+using namespace std;
+
+static int failures{0};
+
+static void check(bool ok, const char *what) {
+  cout << (ok ? "ok   " : "FAIL ") << what << endl;
+  if (!ok) failures++;
+}
+
+// Advances the wheel to `until` and returns the ticks `state` fired on.
+static vector<u_int64_t> fired_ticks(TimerWheel &wheel, TimerState const &state, u_int64_t until) {
+  vector<u_int64_t> ticks{};
+  while (wheel.now() < until) {
+    wheel.advance_to(wheel.now() + 1);
+    if (state.last_fired_tick == wheel.now()) ticks.push_back(wheel.now());
+  }
+  return ticks;
+}
+
+// Advances the wheel to `until` and returns the ticks `task` came due on.
+static vector<u_int64_t> due_ticks(TimerWheel &wheel, RepeatedTask const &task, u_int64_t until) {
+  vector<u_int64_t> ticks{};
+  while (wheel.now() < until) {
+    wheel.advance_to(wheel.now() + 1);
+    if (task.did_tick()) ticks.push_back(wheel.now());
+  }
+  return ticks;
+}
+
+// A one-shot timer `delay` ticks after `start` fires on exactly that tick, whichever level it was placed on.
+static void check_one_shot(u_int64_t start, u_int64_t delay, const char *what) {
+  TimerWheel wheel{1.0 / 60.0};
+  wheel.advance_to(start);
+
+  TimerState state{};
+  wheel.schedule(&state, delay);
+  vector<u_int64_t> ticks = fired_ticks(wheel, state, start + delay + 70);
+  check(ticks == vector<u_int64_t>{start + delay} && wheel.size() == 0, what);
+}
+
+static void test_ticks_from_seconds() {
+  TimerWheel wheel{1.0 / 60.0};
+
+  // Whole-tick durations map to exactly that many ticks.
+  check(wheel.ticks_from_seconds(0.0) == 1, "0 s is 1 tick");
+  check(wheel.ticks_from_seconds(1.0 / 60.0) == 1, "1/60 s is 1 tick");
+  check(wheel.ticks_from_seconds(0.05) == 3, "0.05 s is 3 ticks");
+  check(wheel.ticks_from_seconds(0.1) == 6, "0.1 s is 6 ticks");
+  check(wheel.ticks_from_seconds(1.0) == 60, "1 s is 60 ticks");
+  check(wheel.ticks_from_seconds(1.6) == 96, "1.6 s is 96 ticks");
+  check(wheel.ticks_from_seconds(0.051) == 4, "0.051 s rounds up to 4 ticks");
+
+  // A 0.05 s repeating timer fires on every third tick: 20 times a second.
+  TimerState rapid{};
+  rapid.repeating = true;
+  rapid.interval_seconds = 0.05;
+  wheel.schedule(&rapid, wheel.ticks_from_seconds(rapid.interval_seconds));
+  vector<u_int64_t> ticks = fired_ticks(wheel, rapid, 60);
+  bool on_whole_ticks{true};
+  for (u_int64_t tick : ticks) on_whole_ticks = on_whole_ticks && tick % 3 == 0;
+  check(ticks.size() == 20 && on_whole_ticks, "0.05 s repeating timer fires on every third tick");
+}
+
+static void test_level_boundaries() {
+  for (u_int64_t start : {u_int64_t{0}, u_int64_t{37}}) {
+    cout << "start at tick " << start << ":" << endl;
+    check_one_shot(start, 1, "  1 tick");
+    check_one_shot(start, 63, "  63 ticks, last of level 0");
+    check_one_shot(start, 64, "  64 ticks, first of level 1");
+    check_one_shot(start, 4095, "  4095 ticks, last of level 1");
+    check_one_shot(start, 4096, "  4096 ticks, first of level 2");
+  }
+}
+
+static void test_beyond_max_delta() {
+  TimerWheel wheel{1.0 / 60.0};
+  wheel.advance_to(5);
+
+  TimerState state{};
+  const u_int64_t deadline = 5 + TIMER_WHEEL_MAX_DELTA + 100;
+  wheel.schedule(&state, TIMER_WHEEL_MAX_DELTA + 100);
+  vector<u_int64_t> ticks = fired_ticks(wheel, state, deadline + 70);
+  check(ticks == vector<u_int64_t>{deadline}, "deadline beyond TIMER_WHEEL_MAX_DELTA fires on its tick");
+}
+
+static void test_cancel() {
+  TimerWheel wheel{1.0 / 60.0};
+
+  TimerState first{};
+  TimerWheel::Handle first_handle = wheel.schedule(&first, 2);
+  fired_ticks(wheel, first, 2);
+  check(first.expired && !wheel.is_live(first_handle), "fired one-shot is no longer live");
+  wheel.cancel(first_handle);
+  check(wheel.size() == 0, "cancel after fire is a no-op");
+
+  // The second timer reuses the entry of the first one, the old handle must not reach it.
+  TimerState second{};
+  TimerWheel::Handle second_handle = wheel.schedule(&second, 3);
+  check(second_handle.idx == first_handle.idx, "entry is reused");
+  wheel.cancel(first_handle);
+  check(wheel.is_live(second_handle) && wheel.size() == 1, "stale handle does not cancel the reused entry");
+  check(fired_ticks(wheel, second, 10) == vector<u_int64_t>{5}, "reused entry still fires");
+
+  TimerState cancelled{};
+  TimerWheel::Handle cancelled_handle = wheel.schedule(&cancelled, 4);
+  wheel.cancel(cancelled_handle);
+  check(fired_ticks(wheel, cancelled, 20).empty() && wheel.size() == 0, "cancelled timer never fires");
+}
+
+static void test_repeated_task() {
+  TimerWheel wheel{1.0 / 60.0};
+
+  // 0.1 s: every 6 ticks.
+  RepeatedTask paused{wheel, 0.1};
+  RepeatedTask retimed{wheel, 0.1};
+  check(due_ticks(wheel, paused, 14) == vector<u_int64_t>{6, 12}, "repeats on its interval");
+
+  // Paused briefly, the period continues from the last expiry.
+  paused.pause();
+  check(due_ticks(wheel, paused, 16).empty(), "paused task does not come due");
+  paused.resume();
+  check(due_ticks(wheel, paused, 19) == vector<u_int64_t>{18}, "resume keeps the phase");
+
+  // Paused past its deadline, it comes due right after the resume and counts from there.
+  paused.pause();
+  due_ticks(wheel, paused, 30);
+  paused.resume();
+  check(due_ticks(wheel, paused, 40) == vector<u_int64_t>{31, 37}, "late resume comes due on the next tick");
+
+  // Last expiry of `retimed` was tick 36, the new interval counts from there.
+  retimed.set_interval(0.2);
+  check(due_ticks(wheel, retimed, 70) == vector<u_int64_t>{48, 60}, "set_interval keeps the phase");
+}
+
+static void test_reset() {
+  TimerWheel wheel{1.0 / 60.0};
+
+  RepeatedTask task{wheel, 0.1};
+  TimerState one_shot{};
+  TimerWheel::Handle one_shot_handle = wheel.schedule(&one_shot, 100);
+  task.set_interval(0.2);
+  due_ticks(wheel, task, 50);
+
+  // Back at tick 0 the restarted task repeats the sequence of a new one.
+  wheel.reset();
+  check(wheel.now() == 0 && wheel.size() == 0 && !wheel.is_live(one_shot_handle), "reset drops every timer");
+  wheel.cancel(one_shot_handle);
+  task.restart();
+  check(due_ticks(wheel, task, 14) == vector<u_int64_t>{6, 12}, "restarted task starts over with its first interval");
+  check(fired_ticks(wheel, one_shot, 120).empty(), "dropped timer never fires");
+}
+
+int main() {
+  test_ticks_from_seconds();
+  test_level_boundaries();
+  test_beyond_max_delta();
+  test_cancel();
+  test_repeated_task();
+  test_reset();
+
+  cout << (failures == 0 ? "All passed" : "Failed") << endl;
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "rng.h"
+
+constexpr int TIMER_WHEEL_LEVELS = 4;
+constexpr int TIMER_WHEEL_SLOT_BITS = 6;
+constexpr int TIMER_WHEEL_SLOTS = 1 << TIMER_WHEEL_SLOT_BITS;
+constexpr u_int64_t TIMER_WHEEL_SLOT_MASK = TIMER_WHEEL_SLOTS - 1;
+// Farthest deadline the wheel can place directly, later ones are re-placed while cascading.
+constexpr u_int64_t TIMER_WHEEL_MAX_DELTA = (1ull << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS)) - 1;
+constexpr u_int64_t TIMER_NEVER = UINT64_MAX;
+
+/**
+ * State of a timer, owned by its user and written by the wheel on expiry. Reading it needs no lock and no clock.
+ */
+struct TimerState {
+  u_int64_t last_fired_tick{TIMER_NEVER};
+  bool expired{false};
+  // Optional flag set on (first) expiry - e.g. `should_be_deleted` of a particle.
+  bool *expiry_flag{nullptr};
+
+  // Repeating timers only: re-armed after each expiry with `interval_seconds + [0, jitter_seconds]`.
+  bool repeating{false};
+  double interval_seconds{0.0};
+  double jitter_seconds{0.0};
+  Rng *jitter_rng{nullptr};
+};
+
+/**
+ * Hierarchical timer wheel with one simulation tick resolution.
+ *
+ * Level 0 has one slot per tick, each further level covers `TIMER_WHEEL_SLOTS` slots of the previous. Advancing a tick
+ * only visits the current level 0 slot, plus one slot of a higher level every `TIMER_WHEEL_SLOTS` ticks, whose timers
+ * cascade down. The cost of a tick is proportional to the timers that fire, not to the timers that exist.
+ */
+struct TimerWheel {
+  struct Handle {
+    int idx{-1};
+    u_int32_t generation{0};
+  };
+
+  double tick_seconds;
+
+  explicit TimerWheel(double _tick_seconds) : tick_seconds(_tick_seconds) {
+    for (auto &level : slots) std::fill(std::begin(level), std::end(level), -1);
+  }
+
+  [[nodiscard]] u_int64_t now() const {
+    return current_tick;
+  }
+
+  // Ticks until a deadline `seconds` from now is reached. Always at least one, deadlines are never in the current tick.
+  // The epsilon keeps whole-tick durations (0.05 s at 60 Hz) from rounding up to the next tick.
+  [[nodiscard]] u_int64_t ticks_from_seconds(double seconds) const {
+    if (seconds <= 0.0) return 1;
+    return std::max<u_int64_t>(1, static_cast<u_int64_t>(ceil(seconds / tick_seconds - 1e-9)));
+  }
+
+  Handle schedule(TimerState *state, u_int64_t delay_ticks) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    int idx;
+    if (free_head >= 0) {
+      idx = free_head;
+      free_head = entries[idx].next;
+    } else {
+      idx = static_cast<int>(entries.size());
+      entries.emplace_back();
+    }
+
+    Entry &entry = entries[idx];
+    entry.state = state;
+    entry.deadline = current_tick + std::max<u_int64_t>(1, delay_ticks);
+    entry.in_use = true;
+    link(idx);
+
+    active_count++;
+    return Handle{idx, entry.generation};
+  }
+
+  void cancel(Handle handle) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!is_live(handle)) return;
+
+    unlink(handle.idx);
+    release(handle.idx);
+  }
+
+  [[nodiscard]] bool is_live(Handle handle) const {
+    return handle.idx >= 0 && entries[handle.idx].in_use && entries[handle.idx].generation == handle.generation;
+  }
+
+  [[nodiscard]] int size() const {
+    return active_count;
+  }
+
+  // Drops every timer and starts over at tick 0. Handles of dropped timers are no longer live, cancelling is a no-op.
+  void reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (int idx = 0; idx < static_cast<int>(entries.size()); idx++) {
+      if (entries[idx].in_use) release(idx);
+    }
+    for (auto &level : slots) std::fill(std::begin(level), std::end(level), -1);
+    current_tick = 0;
+  }
+
+  // Advances the wheel tick by tick up to `tick`, firing every timer on the way.
+  void advance_to(u_int64_t tick) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    while (current_tick < tick) {
+      current_tick++;
+      cascade(1);
+      fire_slot(static_cast<int>(current_tick & TIMER_WHEEL_SLOT_MASK));
+    }
+  }
+
+ private:
+  struct Entry {
+    TimerState *state{nullptr};
+    u_int64_t deadline{0};
+    int prev{-1};
+    int next{-1};
+    int level{0};
+    int slot{0};
+    u_int32_t generation{0};
+    bool in_use{false};
+  };
+
+  std::vector<Entry> entries{};
+  int slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS]{};
+  int free_head{-1};
+  int active_count{0};
+  u_int64_t current_tick{0};
+  std::mutex mutex{};
+
+  void link(int idx) {
+    Entry &entry = entries[idx];
+    u_int64_t delta = entry.deadline > current_tick ? entry.deadline - current_tick : 0;
+    u_int64_t placement = entry.deadline;
+    if (delta > TIMER_WHEEL_MAX_DELTA) {
+      delta = TIMER_WHEEL_MAX_DELTA;
+      placement = current_tick + TIMER_WHEEL_MAX_DELTA;
+    }
+
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (1ull << ((level + 1) * TIMER_WHEEL_SLOT_BITS))) level++;
+
+    entry.level = level;
+    entry.slot = static_cast<int>((placement >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK);
+    entry.prev = -1;
+    entry.next = slots[level][entry.slot];
+    if (entry.next >= 0) entries[entry.next].prev = idx;
+    slots[level][entry.slot] = idx;
+  }
+
+  void unlink(int idx) {
+    Entry &entry = entries[idx];
+    if (entry.prev >= 0) {
+      entries[entry.prev].next = entry.next;
+    } else {
+      slots[entry.level][entry.slot] = entry.next;
+    }
+    if (entry.next >= 0) entries[entry.next].prev = entry.prev;
+  }
+
+  void release(int idx) {
+    Entry &entry = entries[idx];
+    entry.in_use = false;
+    entry.state = nullptr;
+    entry.generation++;
+    entry.next = free_head;
+    free_head = idx;
+    active_count--;
+  }
+
+  // Moves the timers of the higher level slot which starts at the current tick one level down.
+  void cascade(int level) {
+    if (level >= TIMER_WHEEL_LEVELS) return;
+    if ((current_tick & ((1ull << (level * TIMER_WHEEL_SLOT_BITS)) - 1)) != 0) return;
+
+    cascade(level + 1);
+
+    int slot = static_cast<int>((current_tick >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK);
+    int idx = slots[level][slot];
+    slots[level][slot] = -1;
+    while (idx >= 0) {
+      int next = entries[idx].next;
+      link(idx);
+      idx = next;
+    }
+  }
+
+  void fire_slot(int slot) {
+    int idx = slots[0][slot];
+    slots[0][slot] = -1;
+
+    while (idx >= 0) {
+      int next = entries[idx].next;
+      Entry &entry = entries[idx];
+
+      if (entry.deadline > current_tick) {
+        // Placed here because its deadline is beyond the wheel's range.
+        link(idx);
+      } else {
+        TimerState &state = *entry.state;
+        state.last_fired_tick = current_tick;
+        if (!state.expired && state.expiry_flag) *state.expiry_flag = true;
+        state.expired = true;
+
+        if (state.repeating) {
+          double jitter = state.jitter_rng ? state.jitter_rng->unit() * state.jitter_seconds : 0.0;
+          entry.deadline = current_tick + ticks_from_seconds(state.interval_seconds + jitter);
+          link(idx);
+        } else {
+          release(idx);
+        }
+      }
+
+      idx = next;
+    }
+  }
+};
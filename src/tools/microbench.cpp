@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../asset_manager.h"
+#include "../common.h"
+#include "../enemy.h"
+#include "../job_system.h"
+#include "../map.h"
+#include "../particles.h"
+#include "../path_finder.h"
+#include "../rng.h"
+#include "raylib.h"
+
+/**
+ * Micro-benchmarks of the hot simulation kernels, each driven against fixed, seeded inputs.
+ *
+ * Usage: microbench [--filter <substring>] [--reps <n>] [--json <file>]
+ *
+ * Assets are loaded headless and the kernels never touch the window or the raylib clock, so this runs without a
+ * display. Every kernel runs its warmup repetitions first, then `reps` timed repetitions of a fixed number of
+ * operations. Times are per operation.
+ */
+
+constexpr u_int64_t MICROBENCH_SEED = 1;
+constexpr int MICROBENCH_WARMUP_REPS = 5;
+constexpr int MICROBENCH_REPS = 30;
+constexpr int MICROBENCH_POINTS = 4096;
+constexpr int MICROBENCH_PATHS = 64;
+constexpr int MICROBENCH_ENEMIES = 200;
+constexpr int MICROBENCH_PARTICLES = 5000;
+
+static volatile u_int64_t microbench_sink{0};
+
+// Keeps the computation of `value` from being optimized away.
+inline void do_not_optimize(u_int64_t value) {
+  microbench_sink = microbench_sink + value;
+}
+
+using MicroClock = std::chrono::steady_clock;
+
+struct MicroStats {
+  double min{};
+  double median{};
+  double mean{};
+  double stddev{};
+  double max{};
+
+  static MicroStats of(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+
+    MicroStats stats{};
+    for (double value : values) stats.mean += value;
+    stats.mean /= values.size();
+    for (double value : values) stats.stddev += (value - stats.mean) * (value - stats.mean);
+    stats.stddev = sqrt(stats.stddev / values.size());
+    stats.min = values.front();
+    stats.median = values.size() % 2 == 1 ? values[values.size() / 2]
+                                          : (values[values.size() / 2 - 1] + values[values.size() / 2]) / 2.0;
+    stats.max = values.back();
+    return stats;
+  }
+};
+
+struct MicroResult {
+  std::string name{};
+  int ops_per_rep{};
+  // Nanoseconds per operation.
+  MicroStats ns{};
+};
+
+struct MicroBench {
+  std::string filter{};
+  int reps{MICROBENCH_REPS};
+  std::vector<MicroResult> results{};
+
+  /**
+   * Times `ops` calls of `op(i)` per repetition. `between_reps` runs untimed after every repetition, to undo what the
+   * kernel accumulates (spawned particles, etc.).
+   */
+  void run(const char *name, int ops, std::function<void(int)> const &op,
+           std::function<void()> const &between_reps = [] {}) {
+    if (!filter.empty() && strstr(name, filter.c_str()) == nullptr) return;
+
+    for (int rep = 0; rep < MICROBENCH_WARMUP_REPS; rep++) {
+      for (int i = 0; i < ops; i++) op(i);
+      between_reps();
+    }
+
+    std::vector<double> ns_per_op{};
+    ns_per_op.reserve(reps);
+    for (int rep = 0; rep < reps; rep++) {
+      auto start = MicroClock::now();
+      for (int i = 0; i < ops; i++) op(i);
+      std::chrono::duration<double, std::nano> elapsed = MicroClock::now() - start;
+      ns_per_op.push_back(elapsed.count() / ops);
+      between_reps();
+    }
+
+    MicroResult result{name, ops, MicroStats::of(std::move(ns_per_op))};
+    printf("%-32s %10.1f %10.1f %10.1f %10.1f %6.1f%%\n", name, result.ns.median, result.ns.mean, result.ns.min,
+           result.ns.max, result.ns.mean > 0.0 ? 100.0 * result.ns.stddev / result.ns.mean : 0.0);
+    fflush(stdout);
+    results.push_back(result);
+  }
+
+  void write_json(std::string const &path) const {
+    FILE *file = fopen(path.c_str(), "w");
+    if (!file) {
+      TraceLog(LOG_ERROR, "Cannot write micro-benchmark report: %s", path.c_str());
+      exit(EXIT_FAILURE);
+    }
+
+    fprintf(file, "{\n  \"reps\": %d,\n  \"kernels\": [\n", reps);
+    for (unsigned int i = 0; i < results.size(); i++) {
+      MicroResult const &result = results[i];
+      fprintf(file,
+              "    {\"name\": \"%s\", \"ops_per_rep\": %d, \"ns_per_op\": {\"min\": %.2f, \"median\": %.2f, "
+              "\"mean\": %.2f, \"stddev\": %.2f, \"max\": %.2f}}%s\n",
+              result.name.c_str(), result.ops_per_rep, result.ns.min, result.ns.median, result.ns.mean,
+              result.ns.stddev, result.ns.max, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+
+    if (fclose(file) != 0) {
+      TraceLog(LOG_ERROR, "Cannot write micro-benchmark report: %s", path.c_str());
+      exit(EXIT_FAILURE);
+    }
+  }
+};
+
+int main(int argc, char **argv) {
+  MicroBench bench{};
+  std::string json_path{};
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+      bench.filter = argv[++i];
+    } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+      bench.reps = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+      json_path = argv[++i];
+    } else {
+      printf("Usage: %s [--filter <substring>] [--reps <n>] [--json <file>]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  SetTraceLogLevel(LOG_WARNING);
+  seed_rngs(MICROBENCH_SEED);
+
+  JobSystem jobs{1};
+  asset_manager.init(jobs, true);
+
+  Map map{};
+  map.view_size = Vector2{WINDOW_W, WINDOW_H};
+  map.init();
+  PathFinder path_finder{};
+  path_finder.init(map);
+
+  auto timer_wheel = std::make_shared<TimerWheel>(1.0 / SIMULATION_TICK_RATE);
+  auto particle_manager = std::make_shared<ParticleManager>(timer_wheel);
+  FrameClock clock{};
+  clock.advance(1.0 / SIMULATION_TICK_RATE);
+
+  // Fixed inputs, the same on every run.
+  Rng input_rng{MICROBENCH_SEED, RNG_STREAM_GAMEPLAY};
+  std::vector<Vector2> points{};
+  for (int i = 0; i < MICROBENCH_POINTS; i++) {
+    points.emplace_back(static_cast<float>(input_rng.range(map.width())),
+                        static_cast<float>(input_rng.range(map.height())));
+  }
+  std::vector<std::pair<Vector2, Vector2>> path_ends{};
+  for (int i = 0; i < MICROBENCH_PATHS; i++) {
+    path_ends.emplace_back(int_vector2_to_vector2(path_finder.discoverable_random_spot()),
+                           int_vector2_to_vector2(path_finder.discoverable_random_spot()));
+  }
+  const Vector2 player_pos = int_vector2_to_vector2(path_finder.discoverable_random_spot());
+  std::list<Enemy> enemies{};
+  // Packed around the player, so the jam control has neighbours to resolve.
+  for (int i = 0; i < MICROBENCH_ENEMIES; i++) {
+    Vector2 pos{player_pos.x + input_rng.range(16 * CELL_DISTANCE) - 8 * CELL_DISTANCE,
+                player_pos.y + input_rng.range(16 * CELL_DISTANCE) - 8 * CELL_DISTANCE};
+    enemies.emplace_back(pos, EnemyType::Regular, particle_manager, timer_wheel);
+  }
+
+  printf("%-32s %10s %10s %10s %10s %7s\n", "kernel (ns/op)", "median", "mean", "min", "max", "cv");
+
+  bench.run("map_is_hit", MICROBENCH_POINTS, [&](int i) { do_not_optimize(map.is_hit(points[i])); });
+
+  bench.run("ordered_cell_indices_from_coord", MICROBENCH_POINTS,
+            [&](int i) { do_not_optimize(ordered_cell_indices_from_coord(points[i]).front().x); });
+
+  bench.run("path_finder_find_path", MICROBENCH_PATHS, [&](int i) {
+    do_not_optimize(path_finder.find_path(path_ends[i].first, path_ends[i].second).size());
+  });
+
+  bench.run("enemy_jam_control", 10, [&](int) {
+    update_enemy_jam_control(enemies, player_pos);
+    do_not_optimize(enemies.front().collision_avoidance_slowdown > 0.f);
+  });
+
+  bench.run("make_explosion", 100, [&](int) { make_explosion(*particle_manager, player_pos, 200.f, 64, GOLD); },
+            [&] { particle_manager->reset(); });
+
+  // The particles never expire as the timer wheel stands still, so every repetition updates the same amount.
+  particle_manager->reset();
+  for (int i = 0; i < MICROBENCH_PARTICLES / 2; i++) {
+    particle_manager->spawn(std::make_unique<SmokeParticle>(points[i % MICROBENCH_POINTS]));
+  }
+  make_explosion(*particle_manager, player_pos, 200.f, MICROBENCH_PARTICLES / 2, GOLD);
+  particle_manager->flush_spawned();
+  bench.run("particle_manager_update", 10, [&](int) { particle_manager->update(clock); });
+  particle_manager->reset();
+
+  if (!json_path.empty()) bench.write_json(json_path);
+  return EXIT_SUCCESS;
+}
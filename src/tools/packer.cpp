@@ -0,0 +1,79 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../pak.h"
+#include "raylib.h"
+
+/**
+ * Builds the asset archive loaded by `AssetManager`.
+ *
+ * Usage: packer <out.pak> [--images <file> ...] [--sounds <file> ...] [--streams <file> ...]
+ *
+ * Images are stored as decoded RGBA pixels, sounds as PCM samples and streams (music) as the original file, which is
+ * decoded while playing. Paths are stored as given, run it from the directory of the executable.
+ */
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    printf("Usage: %s <out.pak> [--images <file> ...] [--sounds <file> ...] [--streams <file> ...]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  SetTraceLogLevel(LOG_WARNING);
+
+  PakWriter writer{};
+  u_int32_t kind{0};
+  for (int i = 2; i < argc; i++) {
+    if (strcmp(argv[i], "--images") == 0) {
+      kind = PAK_ENTRY_IMAGE;
+    } else if (strcmp(argv[i], "--sounds") == 0) {
+      kind = PAK_ENTRY_WAVE;
+    } else if (strcmp(argv[i], "--streams") == 0) {
+      kind = PAK_ENTRY_RAW;
+    } else if (kind == PAK_ENTRY_IMAGE) {
+      Image image = LoadImage(argv[i]);
+      if (!IsImageValid(image)) {
+        TraceLog(LOG_ERROR, "Cannot load image: %s", argv[i]);
+        return EXIT_FAILURE;
+      }
+
+      ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+      writer.add(argv[i], PAK_ENTRY_IMAGE,
+                 {static_cast<u_int32_t>(image.width), static_cast<u_int32_t>(image.height),
+                  static_cast<u_int32_t>(image.format), 1},
+                 image.data, GetPixelDataSize(image.width, image.height, image.format));
+      UnloadImage(image);
+    } else if (kind == PAK_ENTRY_WAVE) {
+      Wave wave = LoadWave(argv[i]);
+      if (!IsWaveValid(wave)) {
+        TraceLog(LOG_ERROR, "Cannot load sound: %s", argv[i]);
+        return EXIT_FAILURE;
+      }
+
+      writer.add(argv[i], PAK_ENTRY_WAVE, {wave.frameCount, wave.sampleRate, wave.sampleSize, wave.channels},
+                 wave.data, static_cast<size_t>(wave.frameCount) * wave.channels * wave.sampleSize / 8);
+      UnloadWave(wave);
+    } else if (kind == PAK_ENTRY_RAW) {
+      int size{0};
+      unsigned char *data = LoadFileData(argv[i], &size);
+      if (!data) {
+        TraceLog(LOG_ERROR, "Cannot load file: %s", argv[i]);
+        return EXIT_FAILURE;
+      }
+
+      writer.add(argv[i], PAK_ENTRY_RAW, {0, 0, 0, 0}, data, size);
+      UnloadFileData(data);
+    } else {
+      TraceLog(LOG_ERROR, "Missing --images, --sounds or --streams before %s", argv[i]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (!writer.write(argv[1])) {
+    TraceLog(LOG_ERROR, "Cannot write asset archive: %s", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  printf("Packed %d assets into %s\n", writer.size(), argv[1]);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "raylib.h"
+
+constexpr int ENEMY_SPAWNER_COUNT = 3;
+constexpr double ENEMY_SPAWN_INTERVAL = 5.0;
+// One in this many spawned enemies is large.
+constexpr int LARGE_ENEMY_ONE_IN = 10;
+constexpr int MAX_COLLECTIBLE_HEALTH_COUNT = 1;
+constexpr int MAX_COLLECTIBLE_BULLET_COUNT = 5;
+constexpr int MAX_COLLECTIBLE_MINE_COUNT = 3;
+
+/**
+ * Gameplay knobs which can change between runs - set from the command line, a tuning file or a benchmark scenario.
+ */
+struct Tuning {
+  int enemy_spawner_count{ENEMY_SPAWNER_COUNT};
+  // Spawners wait while this many enemies are alive. 0 for no limit.
+  int max_enemies{0};
+  double spawn_interval{ENEMY_SPAWN_INTERVAL};
+  // 0 for no large enemies.
+  int large_enemy_one_in{LARGE_ENEMY_ONE_IN};
+  int max_health_collectibles{MAX_COLLECTIBLE_HEALTH_COUNT};
+  int max_bullet_collectibles{MAX_COLLECTIBLE_BULLET_COUNT};
+  int max_mine_collectibles{MAX_COLLECTIBLE_MINE_COUNT};
+
+  // Sets the knob called `key`. Returns false for an unknown key.
+  bool set(const char *key, const char *value) {
+    if (strcmp(key, "spawners") == 0) {
+      enemy_spawner_count = atoi(value);
+    } else if (strcmp(key, "max_enemies") == 0) {
+      max_enemies = atoi(value);
+    } else if (strcmp(key, "spawn_interval") == 0) {
+      spawn_interval = atof(value);
+    } else if (strcmp(key, "large_enemy_one_in") == 0) {
+      large_enemy_one_in = atoi(value);
+    } else if (strcmp(key, "max_health_collectibles") == 0) {
+      max_health_collectibles = atoi(value);
+    } else if (strcmp(key, "max_bullet_collectibles") == 0) {
+      max_bullet_collectibles = atoi(value);
+    } else if (strcmp(key, "max_mine_collectibles") == 0) {
+      max_mine_collectibles = atoi(value);
+    } else {
+      return false;
+    }
+    return true;
+  }
+};
+
+/**
+ * Reads a settings file and calls `apply(key, value)` for each setting, which returns false for an unknown key.
+ *
+ * Format, one setting per line: `<key> <value>`. Empty lines and lines starting with `#` are ignored.
+ */
+template <typename Apply>
+void read_settings_file(std::string const &path, Apply apply) {
+  FILE *file = fopen(path.c_str(), "r");
+  if (!file) {
+    TraceLog(LOG_ERROR, "Cannot open settings file: %s", path.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  char line[256];
+  while (fgets(line, sizeof(line), file)) {
+    if (line[0] == '#' || line[0] == '\n') continue;
+
+    char *key = strtok(line, " \t\r\n");
+    if (!key) continue;
+    char *value = strtok(nullptr, " \t\r\n");
+    if (!value) {
+      TraceLog(LOG_ERROR, "Missing value for %s in %s", key, path.c_str());
+      exit(EXIT_FAILURE);
+    }
+
+    if (!apply(key, value)) {
+      TraceLog(LOG_ERROR, "Unknown setting %s in %s", key, path.c_str());
+      exit(EXIT_FAILURE);
+    }
+  }
+  fclose(file);
+}
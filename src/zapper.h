@@ -11,7 +11,7 @@ struct Zapper : AttackDamage {
   Vector2 start{};
   Vector2 end{};
 
-  Zapper() : AttackDamage() {
+  Zapper() : AttackDamage(), jitter_rng(cosmetic_rng.fork()) {
   }
 
   void draw(Map const& map) const {
@@ -28,26 +28,29 @@ struct Zapper : AttackDamage {
 
       const float dist = Vector2Distance(start, end);
       const float jitter_size = (dist / ZAPPER_BREAKPOINTS) / 3.f;
+      const Vector2 offset = map.draw_offset();
 
       for (int i = 0; i < ZAPPER_BREAKPOINTS; i++) {
         if (i < ZAPPER_BREAKPOINTS - 1) {
-          jitterx = randf_balanced(0.f, jitter_size);
-          jittery = randf_balanced(0.f, jitter_size);
+          jitterx = randf_balanced(jitter_rng, 0.f, jitter_size);
+          jittery = randf_balanced(jitter_rng, 0.f, jitter_size);
         } else {
           jitterx = 0.f;
           jittery = 0.f;
         }
 
-        DrawLineEx(Vector2{start.x + map.world_offset.x + diffx_unit * i + prev_jitterx,
-                           start.y + map.world_offset.y + diffy_unit * i + prev_jittery},
-                   Vector2{start.x + map.world_offset.x + diffx_unit * (i + 1) + jitterx,
-                           start.y + map.world_offset.y + diffy_unit * (i + 1) + jittery},
+        DrawLineEx(Vector2{start.x + offset.x + diffx_unit * i + prev_jitterx,
+                           start.y + offset.y + diffy_unit * i + prev_jittery},
+                   Vector2{start.x + offset.x + diffx_unit * (i + 1) + jitterx,
+                           start.y + offset.y + diffy_unit * (i + 1) + jittery},
                    6, SKYBLUE);
-        DrawLineEx(Vector2{start.x + map.world_offset.x + diffx_unit * i + prev_jitterx,
-                           start.y + map.world_offset.y + diffy_unit * i + prev_jittery},
-                   Vector2{start.x + map.world_offset.x + diffx_unit * (i + 1) + jitterx,
-                           start.y + map.world_offset.y + diffy_unit * (i + 1) + jittery},
+        DrawLineEx(Vector2{start.x + offset.x + diffx_unit * i + prev_jitterx,
+                           start.y + offset.y + diffy_unit * i + prev_jittery},
+                   Vector2{start.x + offset.x + diffx_unit * (i + 1) + jitterx,
+                           start.y + offset.y + diffy_unit * (i + 1) + jittery},
                    2, WHITE);
+        render_stats.line();
+        render_stats.line();
 
         prev_jitterx = jitterx;
         prev_jittery = jittery;
@@ -55,7 +58,12 @@ struct Zapper : AttackDamage {
     }
   }
 
-  [[nodiscard]] float get_attack_damage() const override {
-    return 30.f * GetFrameTime();
+  [[nodiscard]] float get_attack_damage(FrameClock const &clock) const override {
+    return 30.f * clock.dt;
   }
+
+ private:
+  // Own stream for the bolt shape, drawn from once per rendered frame. Taking it from `cosmetic_rng` would make the
+  // particles of the simulation depend on the frame rate.
+  mutable Rng jitter_rng;
 };